@@ -30,6 +30,12 @@ AdafruitTextPlotPipeline tftPipeline(&tft);
 //
 UnicodeFontHandler fontHandler(&tftPipeline, ENCMODE_UTF8);
 
+//
+// The loop below redraws the same digits every 250ms, with a span cache the glyphs are decoded once and kept in RAM,
+// so redrawing them skips reading the bitmaps. Remove this and the setSpanCache call to save the RAM on small boards.
+//
+GlyphSpanCache spanCache(1024);
+
 int yAdaFontSize = 0;
 int yOpenSansSize = 0;
 int baselineAda = 0;
@@ -58,6 +64,8 @@ void setup() {
     tft.begin();
     tft.fillScreen(ILI9341_BLACK);
 
+    fontHandler.setSpanCache(&spanCache);
+
     //
     // Get the size of the Unicode open sans font that we are using, it is returned as a Coord object that has x and y.
     // the baseline, indicates the amount of space below the drawing point that's needed.
@@ -139,4 +147,19 @@ void loop() {
     fontHandler.setDrawColor(ILI9341_GREEN);
     fontHandler.print((float)millis() / 1000.0F);
     fontHandler.print("Agy");
-}
\ No newline at end of file
+
+    //
+    // Opaque text paints the background of each character cell as it draws it, so the text can be redrawn without
+    // erasing it first, and it is drawn in a single pass without flicker. Only the cells of the characters are painted,
+    // so when the text may become shorter, you must clear the rest of the line yourself, as done below.
+    //
+    int opaqueY = 150;
+    fontHandler.setOpaqueText(true);
+    fontHandler.setBackgroundColor(ILI9341_BLACK);
+    fontHandler.setCursor(0, yOpenSansSize + opaqueY);
+    fontHandler.setDrawColor(ILI9341_YELLOW);
+    fontHandler.print((float)millis() / 1000.0F);
+    fontHandler.setOpaqueText(false);
+    int endOfText = tftPipeline.getCursor().x;
+    tft.fillRect(endOfText, opaqueY, tft.width() - endOfText, yOpenSansSize + baselineTcUni, ILI9341_BLACK);
+}
@@ -3,6 +3,7 @@
  * needs no memory allocation, and is safe and compliant with the specification.
  */
 #include <Utf8TextProcessor.h>
+#include <Utf8Iterator.h>
 #include <Wire.h>
 
 using namespace tccore;
@@ -36,6 +37,12 @@ void setup() {
 
     // should you wish to, you can also reset the decoder back to its initial state.
     textProcessor.reset();
+
+    // alternatively, you can pull the characters out of a string one at a time without a callback.
+    for (uint32_t code : Utf8View("Привіт")) {
+        Serial.print("Pulled=");
+        Serial.println(code);
+    }
 }
 
 void loop() {
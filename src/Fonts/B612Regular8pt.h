@@ -135,7 +135,7 @@ const UnicodeFontGlyph B612Regular8ptGlyphs_0[] PROGMEM = {
 };
 
 const UnicodeFontBlock B612Regular8ptBlocks[] PROGMEM = {
-    {0, B612Regular8ptBitmaps_0, B612Regular8ptGlyphs_0, 127} /* Basic Latin */
+    {0, B612Regular8ptBitmaps_0, B612Regular8ptGlyphs_0, 127, 96, TCFONT_BLOCK_DENSE, nullptr} /* Basic Latin */
 };
 
 const UnicodeFont B612Regular8pt[] PROGMEM = { {B612Regular8ptBlocks, 1, 11, TCFONT_ONE_BIT_PER_PIXEL} };
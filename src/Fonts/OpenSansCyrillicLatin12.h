@@ -839,9 +839,9 @@ const UnicodeFontGlyph OpenSansCyrillicLatin12Glyphs_0[] PROGMEM = {
 };
 
 const UnicodeFontBlock OpenSansCyrillicLatin12Blocks[] PROGMEM = {
-    {1024, OpenSansCyrillicLatin12Bitmaps_8, OpenSansCyrillicLatin12Glyphs_8, 255} /* Cyrillic */,
-    {256, OpenSansCyrillicLatin12Bitmaps_2, OpenSansCyrillicLatin12Glyphs_2, 127} /* Latin Extended-A */,
-    {0, OpenSansCyrillicLatin12Bitmaps_0, OpenSansCyrillicLatin12Glyphs_0, 127} /* Basic Latin */
+    {1024, OpenSansCyrillicLatin12Bitmaps_8, OpenSansCyrillicLatin12Glyphs_8, 255, 251, 0, nullptr} /* Cyrillic */,
+    {256, OpenSansCyrillicLatin12Bitmaps_2, OpenSansCyrillicLatin12Glyphs_2, 127, 127, TCFONT_BLOCK_DENSE, nullptr} /* Latin Extended-A */,
+    {0, OpenSansCyrillicLatin12Bitmaps_0, OpenSansCyrillicLatin12Glyphs_0, 127, 96, TCFONT_BLOCK_DENSE, nullptr} /* Basic Latin */
 };
 
 const UnicodeFont OpenSansCyrillicLatin12[] PROGMEM = { {OpenSansCyrillicLatin12Blocks, 3, 19, TCFONT_ONE_BIT_PER_PIXEL} };
@@ -934,9 +934,9 @@ const UnicodeFontGlyph OpenSansCyrillicLatin14Glyphs_0[] PROGMEM = {
 };
 
 const UnicodeFontBlock OpenSansCyrillicLatin14Blocks[] PROGMEM = {
-    {1024, OpenSansCyrillicLatin14Bitmaps_8, OpenSansCyrillicLatin14Glyphs_8, 255} /* Cyrillic */,
-    {256, OpenSansCyrillicLatin14Bitmaps_2, OpenSansCyrillicLatin14Glyphs_2, 127} /* Latin Extended-A */,
-    {0, OpenSansCyrillicLatin14Bitmaps_0, OpenSansCyrillicLatin14Glyphs_0, 127} /* Basic Latin */
+    {1024, OpenSansCyrillicLatin14Bitmaps_8, OpenSansCyrillicLatin14Glyphs_8, 255, 251, 0, nullptr} /* Cyrillic */,
+    {256, OpenSansCyrillicLatin14Bitmaps_2, OpenSansCyrillicLatin14Glyphs_2, 127, 127, TCFONT_BLOCK_DENSE, nullptr} /* Latin Extended-A */,
+    {0, OpenSansCyrillicLatin14Bitmaps_0, OpenSansCyrillicLatin14Glyphs_0, 127, 96, TCFONT_BLOCK_DENSE, nullptr} /* Basic Latin */
 };
 
 const UnicodeFont OpenSansCyrillicLatin14[] PROGMEM = { {OpenSansCyrillicLatin14Blocks, 3, 22, TCFONT_ONE_BIT_PER_PIXEL} };
@@ -1232,9 +1232,9 @@ const UnicodeFontGlyph OpenSansCyrillicLatin18Glyphs_0[] PROGMEM = {
 };
 
 const UnicodeFontBlock OpenSansCyrillicLatin18Blocks[] PROGMEM = {
-    {1024, OpenSansCyrillicLatin18Bitmaps_8, OpenSansCyrillicLatin18Glyphs_8, 255} /* Cyrillic */,
-    {256, OpenSansCyrillicLatin18Bitmaps_2, OpenSansCyrillicLatin18Glyphs_2, 127} /* Latin Extended-A */,
-    {0, OpenSansCyrillicLatin18Bitmaps_0, OpenSansCyrillicLatin18Glyphs_0, 127} /* Basic Latin */
+    {1024, OpenSansCyrillicLatin18Bitmaps_8, OpenSansCyrillicLatin18Glyphs_8, 255, 251, 0, nullptr} /* Cyrillic */,
+    {256, OpenSansCyrillicLatin18Bitmaps_2, OpenSansCyrillicLatin18Glyphs_2, 127, 127, TCFONT_BLOCK_DENSE, nullptr} /* Latin Extended-A */,
+    {0, OpenSansCyrillicLatin18Bitmaps_0, OpenSansCyrillicLatin18Glyphs_0, 127, 96, TCFONT_BLOCK_DENSE, nullptr} /* Basic Latin */
 };
 
 const UnicodeFont OpenSansCyrillicLatin18[] PROGMEM = { {OpenSansCyrillicLatin18Blocks, 3, 28, TCFONT_ONE_BIT_PER_PIXEL} };
@@ -147,7 +147,7 @@ const UnicodeFontGlyph OpenSansRegular10ptGlyphs_0[] PROGMEM = {
 };
 
 const UnicodeFontBlock OpenSansRegular10ptBlocks[] PROGMEM = {
-    {0, OpenSansRegular10ptBitmaps_0, OpenSansRegular10ptGlyphs_0, 127} /* Basic Latin */
+    {0, OpenSansRegular10ptBitmaps_0, OpenSansRegular10ptGlyphs_0, 127, 96, TCFONT_BLOCK_DENSE, nullptr} /* Basic Latin */
 };
 
 const UnicodeFont OpenSansRegular10pt[] PROGMEM = { {OpenSansRegular10ptBlocks, 1, 14, TCFONT_ONE_BIT_PER_PIXEL} };
@@ -161,7 +161,7 @@ const UnicodeFontGlyph OpenSansRegular12ptGlyphs_0[] PROGMEM = {
 };
 
 const UnicodeFontBlock OpenSansRegular12ptBlocks[] PROGMEM = {
-    {0, OpenSansRegular12ptBitmaps_0, OpenSansRegular12ptGlyphs_0, 127} /* Basic Latin */
+    {0, OpenSansRegular12ptBitmaps_0, OpenSansRegular12ptGlyphs_0, 127, 96, TCFONT_BLOCK_DENSE, nullptr} /* Basic Latin */
 };
 
 const UnicodeFont OpenSansRegular12pt[] PROGMEM = { {OpenSansRegular12ptBlocks, 1, 17, TCFONT_ONE_BIT_PER_PIXEL} };
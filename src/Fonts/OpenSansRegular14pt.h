@@ -176,7 +176,7 @@ const UnicodeFontGlyph OpenSansRegular14ptGlyphs_0[] PROGMEM = {
 };
 
 const UnicodeFontBlock OpenSansRegular14ptBlocks[] PROGMEM = {
-    {0, OpenSansRegular14ptBitmaps_0, OpenSansRegular14ptGlyphs_0, 127} /* Basic Latin */
+    {0, OpenSansRegular14ptBitmaps_0, OpenSansRegular14ptGlyphs_0, 127, 96, TCFONT_BLOCK_DENSE, nullptr} /* Basic Latin */
 };
 
 const UnicodeFont OpenSansRegular14pt[] PROGMEM = { {OpenSansRegular14ptBlocks, 1, 19, TCFONT_ONE_BIT_PER_PIXEL} };
@@ -196,7 +196,7 @@ const UnicodeFontGlyph OpenSansRegular16ptGlyphs_0[] PROGMEM = {
 };
 
 const UnicodeFontBlock OpenSansRegular16ptBlocks[] PROGMEM = {
-    {0, OpenSansRegular16ptBitmaps_0, OpenSansRegular16ptGlyphs_0, 127} /* Basic Latin */
+    {0, OpenSansRegular16ptBitmaps_0, OpenSansRegular16ptGlyphs_0, 127, 96, TCFONT_BLOCK_DENSE, nullptr} /* Basic Latin */
 };
 
 const UnicodeFont OpenSansRegular16pt[] PROGMEM = { {OpenSansRegular16ptBlocks, 1, 22, TCFONT_ONE_BIT_PER_PIXEL} };
@@ -219,7 +219,7 @@ const UnicodeFontGlyph OpenSansRegular18ptGlyphs_0[] PROGMEM = {
 };
 
 const UnicodeFontBlock OpenSansRegular18ptBlocks[] PROGMEM = {
-    {0, OpenSansRegular18ptBitmaps_0, OpenSansRegular18ptGlyphs_0, 127} /* Basic Latin */
+    {0, OpenSansRegular18ptBitmaps_0, OpenSansRegular18ptGlyphs_0, 127, 96, TCFONT_BLOCK_DENSE, nullptr} /* Basic Latin */
 };
 
 const UnicodeFont OpenSansRegular18pt[] PROGMEM = { {OpenSansRegular18ptBlocks, 1, 25, TCFONT_ONE_BIT_PER_PIXEL} };
@@ -131,7 +131,7 @@ const UnicodeFontGlyph OpenSansRegular7ptGlyphs_0[] PROGMEM = {
 };
 
 const UnicodeFontBlock OpenSansRegular7ptBlocks[] PROGMEM = {
-    {0, OpenSansRegular7ptBitmaps_0, OpenSansRegular7ptGlyphs_0, 127} /* Basic Latin */
+    {0, OpenSansRegular7ptBitmaps_0, OpenSansRegular7ptGlyphs_0, 127, 96, TCFONT_BLOCK_DENSE, nullptr} /* Basic Latin */
 };
 
 const UnicodeFont OpenSansRegular7pt[] PROGMEM = { {OpenSansRegular7ptBlocks, 1, 10, TCFONT_ONE_BIT_PER_PIXEL} };
@@ -134,7 +134,7 @@ const UnicodeFontGlyph OpenSansRegular8ptGlyphs_0[] PROGMEM = {
 };
 
 const UnicodeFontBlock OpenSansRegular8ptBlocks[] PROGMEM = {
-    {0, OpenSansRegular8ptBitmaps_0, OpenSansRegular8ptGlyphs_0, 127} /* Basic Latin */
+    {0, OpenSansRegular8ptBitmaps_0, OpenSansRegular8ptGlyphs_0, 127, 96, TCFONT_BLOCK_DENSE, nullptr} /* Basic Latin */
 };
 
 const UnicodeFont OpenSansRegular8pt[] PROGMEM = { {OpenSansRegular8ptBlocks, 1, 11, TCFONT_ONE_BIT_PER_PIXEL} };
@@ -304,7 +304,7 @@ const UnicodeFontGlyph RobotoMedium24Glyphs_0[] PROGMEM = {
 };
 
 const UnicodeFontBlock RobotoMedium24Blocks[] PROGMEM = {
-    {0, RobotoMedium24Bitmaps_0, RobotoMedium24Glyphs_0, 127} /* Basic Latin */
+    {0, RobotoMedium24Bitmaps_0, RobotoMedium24Glyphs_0, 127, 96, TCFONT_BLOCK_DENSE, nullptr} /* Basic Latin */
 };
 
 const UnicodeFont RobotoMedium24[] PROGMEM = { {RobotoMedium24Blocks, 1, 33, TCFONT_ONE_BIT_PER_PIXEL} };
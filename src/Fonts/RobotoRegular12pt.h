@@ -386,8 +386,8 @@ const UnicodeFontGlyph RobotoRegular12ptGlyphs_0[] PROGMEM = {
 };
 
 const UnicodeFontBlock RobotoRegular12ptBlocks[] PROGMEM = {
-    {256, RobotoRegular12ptBitmaps_2, RobotoRegular12ptGlyphs_2, 127} /* Latin Extended-A */,
-    {0, RobotoRegular12ptBitmaps_0, RobotoRegular12ptGlyphs_0, 127} /* Basic Latin */
+    {256, RobotoRegular12ptBitmaps_2, RobotoRegular12ptGlyphs_2, 127, 127, TCFONT_BLOCK_DENSE, nullptr} /* Latin Extended-A */,
+    {0, RobotoRegular12ptBitmaps_0, RobotoRegular12ptGlyphs_0, 127, 96, TCFONT_BLOCK_DENSE, nullptr} /* Basic Latin */
 };
 
 const UnicodeFont RobotoRegular12pt[] PROGMEM = { {RobotoRegular12ptBlocks, 2, 18, TCFONT_ONE_BIT_PER_PIXEL} };
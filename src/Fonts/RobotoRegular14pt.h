@@ -423,8 +423,8 @@ const UnicodeFontGlyph RobotoRegular14ptGlyphs_0[] PROGMEM = {
 };
 
 const UnicodeFontBlock RobotoRegular14ptBlocks[] PROGMEM = {
-    {256, RobotoRegular14ptBitmaps_2, RobotoRegular14ptGlyphs_2, 127} /* Latin Extended-A */,
-    {0, RobotoRegular14ptBitmaps_0, RobotoRegular14ptGlyphs_0, 127} /* Basic Latin */
+    {256, RobotoRegular14ptBitmaps_2, RobotoRegular14ptGlyphs_2, 127, 127, TCFONT_BLOCK_DENSE, nullptr} /* Latin Extended-A */,
+    {0, RobotoRegular14ptBitmaps_0, RobotoRegular14ptGlyphs_0, 127, 96, TCFONT_BLOCK_DENSE, nullptr} /* Basic Latin */
 };
 
 const UnicodeFont RobotoRegular14pt[] PROGMEM = { {RobotoRegular14ptBlocks, 2, 20, TCFONT_ONE_BIT_PER_PIXEL} };
@@ -482,8 +482,8 @@ const UnicodeFontGlyph RobotoRegular16ptGlyphs_0[] PROGMEM = {
 };
 
 const UnicodeFontBlock RobotoRegular16ptBlocks[] PROGMEM = {
-    {256, RobotoRegular16ptBitmaps_2, RobotoRegular16ptGlyphs_2, 127} /* Latin Extended-A */,
-    {0, RobotoRegular16ptBitmaps_0, RobotoRegular16ptGlyphs_0, 127} /* Basic Latin */
+    {256, RobotoRegular16ptBitmaps_2, RobotoRegular16ptGlyphs_2, 127, 127, TCFONT_BLOCK_DENSE, nullptr} /* Latin Extended-A */,
+    {0, RobotoRegular16ptBitmaps_0, RobotoRegular16ptGlyphs_0, 127, 96, TCFONT_BLOCK_DENSE, nullptr} /* Basic Latin */
 };
 
 const UnicodeFont RobotoRegular16pt[] PROGMEM = { {RobotoRegular16ptBlocks, 2, 23, TCFONT_ONE_BIT_PER_PIXEL} };
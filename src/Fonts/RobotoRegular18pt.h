@@ -546,8 +546,8 @@ const UnicodeFontGlyph RobotoRegular18ptGlyphs_0[] PROGMEM = {
 };
 
 const UnicodeFontBlock RobotoRegular18ptBlocks[] PROGMEM = {
-    {256, RobotoRegular18ptBitmaps_2, RobotoRegular18ptGlyphs_2, 127} /* Latin Extended-A */,
-    {0, RobotoRegular18ptBitmaps_0, RobotoRegular18ptGlyphs_0, 127} /* Basic Latin */
+    {256, RobotoRegular18ptBitmaps_2, RobotoRegular18ptGlyphs_2, 127, 127, TCFONT_BLOCK_DENSE, nullptr} /* Latin Extended-A */,
+    {0, RobotoRegular18ptBitmaps_0, RobotoRegular18ptGlyphs_0, 127, 96, TCFONT_BLOCK_DENSE, nullptr} /* Basic Latin */
 };
 
 const UnicodeFont RobotoRegular18pt[] PROGMEM = { {RobotoRegular18ptBlocks, 2, 26, TCFONT_ONE_BIT_PER_PIXEL} };
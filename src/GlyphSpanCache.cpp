@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2018 https://www.thecoderscorner.com (Dave Cherry).
+ * This product is licensed under an Apache license, see the LICENSE file in the top-level directory.
+ */
+
+#include "tcUnicodeHelper.h"
+#include "GlyphSpanCache.h"
+
+GlyphSpanCache::GlyphSpanCache(size_t bytes) {
+    setByteBudget(bytes);
+}
+
+GlyphSpanCache::~GlyphSpanCache() {
+    delete[] arena;
+}
+
+void GlyphSpanCache::setByteBudget(size_t bytes) {
+    delete[] arena;
+    arena = (bytes != 0) ? new uint8_t[bytes] : nullptr;
+    capacity = (arena != nullptr) ? bytes : 0;
+    clear();
+}
+
+void GlyphSpanCache::clear() {
+    head = tail = wrapEnd = 0;
+    entryCount = 0;
+    wrapped = false;
+}
+
+size_t GlyphSpanCache::entrySize(uint16_t spanCount) {
+    // keep every header aligned, the spans themselves are bytes.
+    const size_t align = alignof(EntryHeader);
+    size_t size = sizeof(EntryHeader) + ((size_t)spanCount * sizeof(GlyphSpan));
+    return (size + align - 1) & ~(align - 1);
+}
+
+const GlyphSpan* GlyphSpanCache::findSpans(const void* font, uint32_t code, uint16_t& spanCount) {
+    size_t position = head;
+    bool beforeWrap = wrapped;
+    for (uint16_t i = 0; i < entryCount; i++) {
+        auto header = (EntryHeader*)(arena + position);
+        if (header->font == font && header->code == code) {
+            hits++;
+            spanCount = header->spanCount;
+            return (const GlyphSpan*)(header + 1);
+        }
+        position += entrySize(header->spanCount);
+        if (beforeWrap && position >= wrapEnd) {
+            position = 0;
+            beforeWrap = false;
+        }
+    }
+    misses++;
+    return nullptr;
+}
+
+void GlyphSpanCache::removeOldest() {
+    head += entrySize(((EntryHeader*)(arena + head))->spanCount);
+    entryCount--;
+    if (entryCount == 0) {
+        clear();
+    } else if (wrapped && head >= wrapEnd) {
+        head = 0;
+        wrapped = false;
+    }
+}
+
+uint8_t* GlyphSpanCache::allocate(size_t size) {
+    if (size > capacity) return nullptr;
+    while (entryCount >= TC_GLYPH_SPAN_CACHE_MAX_GLYPHS) removeOldest();
+
+    // entries are added at the tail and removed from the head, when the end is reached it starts again at the front.
+    while (true) {
+        if (!wrapped) {
+            if (tail + size <= capacity) break;
+            wrapEnd = tail;
+            tail = 0;
+            wrapped = true;
+        }
+        if (tail + size <= head) break;
+        removeOldest();
+    }
+    uint8_t* entry = arena + tail;
+    tail += size;
+    entryCount++;
+    return entry;
+}
+
+const GlyphSpan* GlyphSpanCache::storeSpans(const void* font, uint32_t code, const uint8_t* bitmap, uint8_t w,
+                                            uint8_t h, uint16_t& spanCount) {
+    if (arena == nullptr) return nullptr;
+
+    // count the spans first so that exactly the right amount of space is taken
+    uint32_t count = 0;
+    forEachGlyphSpan(bitmap, w, h, [&count](uint8_t, uint8_t, uint8_t) { count++; });
+    if (count > 0xFFFF) return nullptr;
+
+    auto header = (EntryHeader*)allocate(entrySize(count));
+    if (header == nullptr) return nullptr;
+    header->font = font;
+    header->code = code;
+    header->spanCount = count;
+    auto spans = (GlyphSpan*)(header + 1);
+    uint16_t next = 0;
+    forEachGlyphSpan(bitmap, w, h, [spans, &next](uint8_t col, uint8_t row, uint8_t len) {
+        spans[next++] = GlyphSpan{col, row, len};
+    });
+    spanCount = count;
+    return spans;
+}
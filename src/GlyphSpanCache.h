@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2018 https://www.thecoderscorner.com (Dave Cherry).
+ * This product is licensed under an Apache license, see the LICENSE file in the top-level directory.
+ */
+
+#ifndef TCMENU_GLYPH_SPAN_CACHE_H
+#define TCMENU_GLYPH_SPAN_CACHE_H
+
+#include <stddef.h>
+#include <inttypes.h>
+
+/**
+ * @file GlyphSpanCache.h
+ * @brief contains an optional RAM cache of glyphs that are already decoded into horizontal spans.
+ */
+
+/**
+ * The most glyphs that a span cache holds at once, which limits the glyphs each lookup has to check.
+ */
+#ifndef TC_GLYPH_SPAN_CACHE_MAX_GLYPHS
+#define TC_GLYPH_SPAN_CACHE_MAX_GLYPHS 48
+#endif
+
+/**
+ * A horizontal run of set bits within a glyph, the column and row are relative to the glyph origin.
+ */
+struct GlyphSpan {
+    uint8_t col;
+    uint8_t row;
+    uint8_t length;
+};
+
+/**
+ * Holds recently drawn one bit per pixel glyphs as lists of spans, so that drawing them again needs no bitmap decoding
+ * at all. This suits displays that redraw the same few characters over and over, such as a status line with digits
+ * and units. Glyphs are added the first time they are drawn, and are packed one after another into a single block of
+ * memory of the budget size. When there is no room, the oldest glyphs are removed until the new one fits. A glyph that
+ * needs more than the whole budget is never cached, it is just drawn from the bitmap each time.
+ *
+ * Each lookup compares against every glyph in the cache in turn, so the cost of a lookup grows with the number of
+ * glyphs held. To keep that bounded however large the budget, at most `TC_GLYPH_SPAN_CACHE_MAX_GLYPHS` glyphs are kept,
+ * the oldest being removed first as with a full budget.
+ *
+ * Provide a cache to a `UnicodeFontHandler` using `setSpanCache`, the handler does not take ownership, and a handler
+ * without one pays nothing for it. The cache is not thread safe, so give each handler that renders on its own task or
+ * core a cache of its own.
+ */
+class GlyphSpanCache {
+private:
+    struct EntryHeader {
+        const void* font;
+        uint32_t code;
+        uint16_t spanCount;
+    };
+
+    uint8_t* arena = nullptr;
+    size_t capacity = 0;
+    size_t head = 0;
+    size_t tail = 0;
+    size_t wrapEnd = 0;
+    uint16_t entryCount = 0;
+    bool wrapped = false;
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+public:
+    /**
+     * Create a span cache that uses at most the given amount of memory, which is allocated once here.
+     * @param bytes the size of the cache in bytes, 0 creates a cache that holds nothing
+     */
+    explicit GlyphSpanCache(size_t bytes);
+    ~GlyphSpanCache();
+    GlyphSpanCache(const GlyphSpanCache&) = delete;
+    GlyphSpanCache& operator=(const GlyphSpanCache&) = delete;
+
+    /**
+     * Changes the most memory the cache can use, the memory is allocated again here, and any glyphs already cached are
+     * removed. A budget of zero turns the cache off and frees its memory.
+     * @param bytes the size of the cache in bytes
+     */
+    void setByteBudget(size_t bytes);
+
+    /**
+     * Look for the spans of a glyph in the cache.
+     * @param font the font that the glyph belongs to, either a TcUnicode or Adafruit font
+     * @param code the code point to find
+     * @param spanCount set to the number of spans when found
+     * @return the spans in row order, or nullptr if the glyph is not in the cache
+     */
+    const GlyphSpan* findSpans(const void* font, uint32_t code, uint16_t& spanCount);
+
+    /**
+     * Decode the bitmap of a glyph into spans and add them to the cache, removing the oldest glyphs if needed.
+     * @param font the font that the glyph belongs to, either a TcUnicode or Adafruit font
+     * @param code the code point of the glyph
+     * @param bitmap the one bit per pixel glyph bitmap, see forEachGlyphSpan
+     * @param w the width of the glyph
+     * @param h the height of the glyph
+     * @param spanCount set to the number of spans when stored
+     * @return the spans in row order, or nullptr if the glyph would not fit within the budget
+     */
+    const GlyphSpan* storeSpans(const void* font, uint32_t code, const uint8_t* bitmap, uint8_t w, uint8_t h,
+                                uint16_t& spanCount);
+
+    /** Remove all glyphs from the cache, the statistics are left as they are */
+    void clear();
+
+    /** @return true if the cache has a budget and can hold glyphs */
+    bool isEnabled() const { return arena != nullptr; }
+    /** @return the budget in bytes */
+    size_t getByteBudget() const { return capacity; }
+    /** @return the bytes taken up by the glyphs currently in the cache */
+    size_t getBytesUsed() const { return wrapped ? (wrapEnd - head) + tail : tail - head; }
+    /** @return the number of glyphs currently in the cache */
+    uint16_t getGlyphCount() const { return entryCount; }
+    /** @return the number of lookups that were found in the cache */
+    uint32_t getHits() const { return hits; }
+    /** @return the number of lookups that were not found in the cache */
+    uint32_t getMisses() const { return misses; }
+    /** reset the hit and miss counters back to zero */
+    void resetStatistics() { hits = misses = 0; }
+
+private:
+    static size_t entrySize(uint16_t spanCount);
+    uint8_t* allocate(size_t size);
+    void removeOldest();
+};
+
+#endif //TCMENU_GLYPH_SPAN_CACHE_H
@@ -96,6 +96,15 @@ typedef struct {
     int8_t yOffset;
 } UnicodeFontGlyph;
 
+/**
+ * Flags that describe how the glyphs in a unicode block are laid out, they can be combined. A dense block has a glyph
+ * for every character from the first glyph's relativeChar onwards with no gaps, so a glyph can be found directly by its
+ * index instead of searching. An Eytzinger block has its glyphs (and keys if present) stored in breadth first order of
+ * a binary search tree rather than sorted order, the children of entry k are at 2k+1 and 2k+2, so the entries visited
+ * during a search are close together near the top of the tree.
+ */
+enum UnicodeBlockFlags: uint8_t { TCFONT_BLOCK_DENSE = 0x01, TCFONT_BLOCK_EYTZINGER = 0x02 };
+
 /**
  * A unicode block is a range of character akin to a code page. In this structure we store the bitmaps and glyphs that
  * are associated with the block range. This allows us to be more efficient with memory overall. The char nums in a glyph
@@ -110,6 +119,15 @@ typedef struct {
     const UnicodeFontGlyph *glyphs;
     /** The number of points in this block */
     uint16_t numberOfPoints;
+    /** The number of entries in the glyphs array, fonts generated before this was added leave it as 0 */
+    uint16_t numberOfGlyphs;
+    /** Combination of UnicodeBlockFlags describing the glyph layout, 0 if there is nothing special about it */
+    uint8_t blockFlags;
+    /**
+     * Optional packed array of the relativeChar of each glyph in the same order as the glyphs, when present the search
+     * only reads these keys and the full glyph is read once found. Requires numberOfGlyphs, can be nullptr.
+     */
+    const uint16_t *glyphKeys;
 } UnicodeFontBlock;
 
 /**
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2018 https://www.thecoderscorner.com (Dave Cherry).
+ * This product is licensed under an Apache license, see the LICENSE file in the top-level directory.
+ */
+
+#include "tcUnicodeHelper.h"
+#include "UnicodeGlyphCache.h"
+
+UnicodeGlyphCache::UnicodeGlyphCache(uint16_t size) {
+    numberOfSets = (size + TC_GLYPH_CACHE_WAYS - 1) / TC_GLYPH_CACHE_WAYS;
+    if (numberOfSets == 0) numberOfSets = 1;
+    entries = new CacheEntry[getCapacity()];
+    clear();
+}
+
+UnicodeGlyphCache::~UnicodeGlyphCache() {
+    delete[] entries;
+}
+
+void UnicodeGlyphCache::clear() {
+    for (uint32_t i = 0; i < getCapacity(); i++) {
+        entries[i].font = nullptr;
+        entries[i].lastUsed = 0;
+    }
+}
+
+UnicodeGlyphCache::CacheEntry* UnicodeGlyphCache::setFor(const void* font, uint32_t code) const {
+    // consecutive code points land in consecutive sets, the font address spreads different fonts apart.
+    uint32_t key = code ^ (uint32_t)((uintptr_t)font >> 4);
+    return &entries[(key % numberOfSets) * TC_GLYPH_CACHE_WAYS];
+}
+
+bool UnicodeGlyphCache::findGlyph(const void* font, uint32_t code, GlyphWithBitmap& glyphBitmap) {
+    CacheEntry* set = setFor(font, code);
+    for (int i = 0; i < TC_GLYPH_CACHE_WAYS; i++) {
+        if (set[i].font == font && set[i].code == code) {
+            set[i].lastUsed = ++useCounter;
+            glyphBitmap.setGlyph(&set[i].glyph);
+            glyphBitmap.setBitmapData(set[i].bitmap);
+            hits++;
+            return true;
+        }
+    }
+    misses++;
+    return false;
+}
+
+void UnicodeGlyphCache::storeGlyph(const void* font, uint32_t code, const GlyphWithBitmap& glyphBitmap) {
+    if (glyphBitmap.getGlyph() == nullptr) return;
+
+    CacheEntry* set = setFor(font, code);
+    CacheEntry* victim = &set[0];
+    for (int i = 0; i < TC_GLYPH_CACHE_WAYS; i++) {
+        if (set[i].font == nullptr) {
+            victim = &set[i];
+            break;
+        }
+        if (set[i].lastUsed < victim->lastUsed) victim = &set[i];
+    }
+
+    victim->font = font;
+    victim->code = code;
+    victim->bitmap = glyphBitmap.getBitmapData();
+    victim->glyph = *glyphBitmap.getGlyph();
+    victim->lastUsed = ++useCounter;
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2018 https://www.thecoderscorner.com (Dave Cherry).
+ * This product is licensed under an Apache license, see the LICENSE file in the top-level directory.
+ */
+
+#ifndef TCMENU_UNICODE_GLYPH_CACHE_H
+#define TCMENU_UNICODE_GLYPH_CACHE_H
+
+#include <inttypes.h>
+#include "UnicodeFontDefs.h"
+
+/**
+ * @file UnicodeGlyphCache.h
+ * @brief contains an optional cache of recently used glyphs that sits in front of the font lookup.
+ */
+
+class GlyphWithBitmap;
+
+/**
+ * The number of entries in each set of the glyph cache, a glyph can be held in any entry of the set its key maps to.
+ */
+#define TC_GLYPH_CACHE_WAYS 4
+
+/**
+ * An optional cache of recently used glyphs, keyed by font and code point. Menus tend to redraw the same few dozen
+ * characters over and over, so with a cache of 32 to 64 entries nearly all lookups avoid searching the font tables in
+ * program memory. The cache is set associative, each key maps onto a set of `TC_GLYPH_CACHE_WAYS` entries, and when a
+ * set is full the least recently used entry in that set is replaced. Hit and miss counters are kept so that the size
+ * can be tuned.
+ *
+ * Provide a cache to a `UnicodeFontHandler` using `setGlyphCache`, the handler does not take ownership. The cache itself
+ * is not thread safe, so if handlers on different tasks or cores are rendering at the same time, give each one its own.
+ */
+class UnicodeGlyphCache {
+public:
+    struct CacheEntry {
+        const void* font;
+        uint32_t code;
+        const uint8_t* bitmap;
+        uint32_t lastUsed;
+        UnicodeFontGlyph glyph;
+    };
+private:
+    CacheEntry* entries;
+    uint16_t numberOfSets;
+    uint32_t useCounter = 0;
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+public:
+    /**
+     * Create a glyph cache that can hold at least the requested number of glyphs, the size is rounded up to a whole
+     * number of sets. The entries are allocated once here and never again.
+     * @param size the number of glyphs to hold
+     */
+    explicit UnicodeGlyphCache(uint16_t size);
+    ~UnicodeGlyphCache();
+    UnicodeGlyphCache(const UnicodeGlyphCache&) = delete;
+    UnicodeGlyphCache& operator=(const UnicodeGlyphCache&) = delete;
+
+    /**
+     * Look for a glyph in the cache, if found the glyph and bitmap are copied into the glyph bitmap provided.
+     * @param font the font that the glyph belongs to, either a TcUnicode or Adafruit font
+     * @param code the code point to find
+     * @param glyphBitmap filled in with the glyph and bitmap when found
+     * @return true if the glyph was in the cache, otherwise false.
+     */
+    bool findGlyph(const void* font, uint32_t code, GlyphWithBitmap& glyphBitmap);
+
+    /**
+     * Store a glyph in the cache, replacing the least recently used entry in its set if needed.
+     * @param font the font that the glyph belongs to, either a TcUnicode or Adafruit font
+     * @param code the code point of the glyph
+     * @param glyphBitmap the glyph and bitmap to store
+     */
+    void storeGlyph(const void* font, uint32_t code, const GlyphWithBitmap& glyphBitmap);
+
+    /** Remove all entries from the cache, the statistics are left as they are */
+    void clear();
+
+    /** @return the number of glyphs the cache can hold */
+    uint32_t getCapacity() const { return (uint32_t)numberOfSets * TC_GLYPH_CACHE_WAYS; }
+    /** @return the number of lookups that were found in the cache */
+    uint32_t getHits() const { return hits; }
+    /** @return the number of lookups that were not found in the cache */
+    uint32_t getMisses() const { return misses; }
+    /** reset the hit and miss counters back to zero */
+    void resetStatistics() { hits = misses = 0; }
+
+private:
+    CacheEntry* setFor(const void* font, uint32_t code) const;
+};
+
+#endif //TCMENU_UNICODE_GLYPH_CACHE_H
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2018 https://www.thecoderscorner.com (Dave Cherry).
+ * This product is licensed under an Apache license, see the LICENSE file in the top-level directory.
+ */
+
+#include "Utf8BulkDecoder.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TC_UTF8_KERNEL_AVX2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define TC_UTF8_KERNEL_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define TC_UTF8_KERNEL_NEON
+#endif
+
+using namespace tccore;
+
+namespace {
+
+    /**
+     * Converts whole blocks of ASCII from the start of the input, stopping at the first block that contains anything
+     * else, the caller deals with whatever is left.
+     * @return the number of bytes converted, each one is written to out.
+     */
+    size_t convertAsciiBlocks(const uint8_t* in, size_t len, uint32_t* out) {
+        size_t i = 0;
+#if defined(TC_UTF8_KERNEL_AVX2)
+        while (i + 32 <= len) {
+            __m256i block = _mm256_loadu_si256((const __m256i*)(in + i));
+            if (_mm256_movemask_epi8(block) != 0) break;
+            for (int part = 0; part < 4; part++) {
+                __m128i eightBytes = _mm_loadl_epi64((const __m128i*)(in + i + (part * 8)));
+                _mm256_storeu_si256((__m256i*)(out + i + (part * 8)), _mm256_cvtepu8_epi32(eightBytes));
+            }
+            i += 32;
+        }
+#elif defined(TC_UTF8_KERNEL_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        while (i + 16 <= len) {
+            __m128i block = _mm_loadu_si128((const __m128i*)(in + i));
+            if (_mm_movemask_epi8(block) != 0) break;
+            __m128i low = _mm_unpacklo_epi8(block, zero);
+            __m128i high = _mm_unpackhi_epi8(block, zero);
+            _mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi16(low, zero));
+            _mm_storeu_si128((__m128i*)(out + i + 4), _mm_unpackhi_epi16(low, zero));
+            _mm_storeu_si128((__m128i*)(out + i + 8), _mm_unpacklo_epi16(high, zero));
+            _mm_storeu_si128((__m128i*)(out + i + 12), _mm_unpackhi_epi16(high, zero));
+            i += 16;
+        }
+#elif defined(TC_UTF8_KERNEL_NEON)
+        while (i + 16 <= len) {
+            uint8x16_t block = vld1q_u8(in + i);
+            if (vmaxvq_u8(block) >= 0x80) break;
+            uint16x8_t low = vmovl_u8(vget_low_u8(block));
+            uint16x8_t high = vmovl_u8(vget_high_u8(block));
+            vst1q_u32(out + i, vmovl_u16(vget_low_u16(low)));
+            vst1q_u32(out + i + 4, vmovl_u16(vget_high_u16(low)));
+            vst1q_u32(out + i + 8, vmovl_u16(vget_low_u16(high)));
+            vst1q_u32(out + i + 12, vmovl_u16(vget_high_u16(high)));
+            i += 16;
+        }
+#endif
+        // whatever is left, or everything without SIMD, is found a word at a time.
+        size_t asciiEnd = i + utf8AsciiPrefixLength((const char*)in + i, len - i);
+        for (; i < asciiEnd; i++) out[i] = in[i];
+        return i;
+    }
+
+    /**
+     * Converts a run of two byte sequences from the start of the input, which covers the letters of Cyrillic, Greek,
+     * Hebrew, Arabic and the accented Latin, stopping at anything else, the caller deals with whatever is left. The
+     * overlong leads 0xC0 and 0xC1 are not part of a run, so the caller reports them as usual.
+     * @return the number of bytes converted, each pair is written to out as one character.
+     */
+    size_t convertTwoByteRun(const uint8_t* in, size_t len, uint32_t* out) {
+        size_t i = 0;
+        while (i + 2 <= len) {
+            uint8_t lead = in[i];
+            uint8_t continuation = in[i + 1];
+            if ((uint8_t)(lead - 0xC2) > (0xDF - 0xC2) || (continuation & 0xC0) != 0x80) break;
+            *out++ = ((uint32_t)(lead & 0x1F) << 6) | (continuation & 0x3F);
+            i += 2;
+        }
+        return i;
+    }
+
+    class BulkDecodeOutput {
+    private:
+        uint32_t* out;
+        size_t* errorPositions;
+        size_t maxErrorPositions;
+    public:
+        Utf8DecodeResult result = {0, 0};
+
+        BulkDecodeOutput(uint32_t* out, size_t* errorPositions, size_t maxErrorPositions)
+                : out(out), errorPositions(errorPositions), maxErrorPositions(maxErrorPositions) {}
+
+        void character(uint32_t ch) { out[result.written++] = ch; }
+
+        void error(size_t position) {
+            if (errorPositions != nullptr && result.errorCount < maxErrorPositions) {
+                errorPositions[result.errorCount] = position;
+            }
+            result.errorCount++;
+            out[result.written++] = TC_UNICODE_CHAR_ERROR;
+        }
+
+        uint32_t* currentOutput() { return out + result.written; }
+        void advance(size_t count) { result.written += count; }
+    };
+}
+
+const char* tccore::utf8DecodeKernelName() {
+#if defined(TC_UTF8_KERNEL_AVX2)
+    return "avx2";
+#elif defined(TC_UTF8_KERNEL_SSE2)
+    return "sse2";
+#elif defined(TC_UTF8_KERNEL_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+Utf8DecodeResult tccore::decodeUtf8(const uint8_t* in, size_t len, uint32_t* out, size_t* errorPositions,
+                                    size_t maxErrorPositions) {
+    BulkDecodeOutput output(out, errorPositions, maxErrorPositions);
+    size_t i = 0;
+    int needed = 0;         // continuation bytes still to come in the current sequence
+    int extraChars = 0;     // continuation bytes the current sequence started with
+    uint32_t current = 0;
+    size_t sequenceStart = 0;
+
+    while (i < len) {
+        if (needed == 0) {
+            // text such as Cyrillic alternates short runs of two byte letters with spaces and punctuation.
+            size_t converted;
+            do {
+                converted = convertAsciiBlocks(in + i, len - i, output.currentOutput());
+                output.advance(converted);
+                i += converted;
+                size_t pairBytes = convertTwoByteRun(in + i, len - i, output.currentOutput());
+                output.advance(pairBytes / 2);
+                i += pairBytes;
+                converted += pairBytes;
+            } while (converted != 0 && i < len);
+            if (i == len) break;
+        }
+
+        uint8_t data = in[i];
+        if (data == 0xFE || data == 0xFF) {
+            needed = 0;
+            output.error(i);
+        } else if (needed != 0 && (data & 0xC0) == 0x80) {
+            current = (current << 6) | (data & 0x3F);
+            if (--needed == 0) {
+                // the same overlong rules as Utf8TextProcessor::couldSequenceBeSmaller
+                bool overlong = current < 0x80 || (current < 0x800 && extraChars > 1) ||
+                                (current < 0x10000 && extraChars > 2);
+                if (overlong) output.error(i); else output.character(current);
+            }
+        } else {
+            if (needed != 0) {
+                // the sequence was broken, report it and then treat this byte as the start of a new one, apart from
+                // nul which Utf8TextProcessor does not pass on in this case.
+                needed = 0;
+                output.error(i);
+                if (data == 0) {
+                    i++;
+                    continue;
+                }
+            }
+            sequenceStart = i;
+            if (data < 0x80) {
+                output.character(data);
+            } else if ((data & 0xE0) == 0xC0) {
+                current = data & 0x1FU;
+                needed = extraChars = 1;
+            } else if ((data & 0xF0) == 0xE0) {
+                current = data & 0x0FU;
+                needed = extraChars = 2;
+            } else if ((data & 0xF8) == 0xF0) {
+                current = data & 0x07U;
+                needed = extraChars = 3;
+            } else {
+                output.error(i);
+            }
+        }
+        i++;
+    }
+
+    if (needed != 0) output.error(sequenceStart);
+    return output.result;
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2018 https://www.thecoderscorner.com (Dave Cherry).
+ * This product is licensed under an Apache license, see the LICENSE file in the top-level directory.
+ */
+
+#ifndef TCMENU_UTF8_BULK_DECODER_H
+#define TCMENU_UTF8_BULK_DECODER_H
+
+#include <string.h>
+#include <inttypes.h>
+#include "Utf8TextProcessor.h"
+
+/**
+ * @file Utf8BulkDecoder.h
+ * @brief contains a bulk UTF-8 decoder for complete buffers, with SIMD kernels for ASCII runs on host builds.
+ */
+
+namespace tccore {
+
+    /**
+     * The outcome of decoding a buffer in bulk with `decodeUtf8`
+     */
+    struct Utf8DecodeResult {
+        /** the number of entries written to the output, including any error markers */
+        size_t written;
+        /** the number of errors found, which may be more than the number of positions recorded */
+        size_t errorCount;
+    };
+
+    /**
+     * Decodes a complete buffer of UTF-8 into code points. The rules are exactly those of `Utf8TextProcessor`, and the
+     * output is the same sequence of characters and `TC_UNICODE_CHAR_ERROR` markers that its handler would receive for
+     * the same bytes. The only difference is that as the buffer is complete, a sequence cut short by the end of the data
+     * is reported as one last error.
+     *
+     * Only runs of ASCII are vectorised, they are converted in blocks using AVX2 or SSE2 on x86, NEON on 64 bit ARM,
+     * and a word at a time otherwise. The kernel is chosen when compiling, see `utf8DecodeKernelName`. Runs of two byte
+     * letters, such as Cyrillic or Greek, are converted by a short scalar loop that skips the decoder state, and
+     * everything else, including three and four byte sequences, goes through the full decoder one byte at a time.
+     *
+     * @param in the UTF-8 data
+     * @param len the number of bytes of data
+     * @param out receives the code points and error markers, it must have room for at least len entries.
+     * @param errorPositions optionally receives the byte offset at which each error was found, for a sequence cut short
+     *                       by the end of the data this is the offset of its first byte. Can be nullptr.
+     * @param maxErrorPositions the number of entries available in errorPositions
+     * @return the number of entries written and the number of errors
+     */
+    Utf8DecodeResult decodeUtf8(const uint8_t* in, size_t len, uint32_t* out, size_t* errorPositions = nullptr,
+                                size_t maxErrorPositions = 0);
+
+    /**
+     * @return the name of the kernel `decodeUtf8` uses for ASCII runs in this build, for example "sse2".
+     */
+    const char* utf8DecodeKernelName();
+}
+
+#endif //TCMENU_UTF8_BULK_DECODER_H
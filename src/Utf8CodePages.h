@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) 2018 https://www.thecoderscorner.com (Dave Cherry).
+ * This product is licensed under an Apache license, see the LICENSE file in the top-level directory.
+ */
+
+#ifndef TCMENU_UTF8_CODE_PAGES_H
+#define TCMENU_UTF8_CODE_PAGES_H
+
+#include <inttypes.h>
+
+/**
+ * @file Utf8CodePages.h
+ * @brief contains tables for single byte code pages, used with ENCMODE_EXT_ASCII to turn legacy text into unicode.
+ */
+
+namespace tccore {
+    /*
+     * Each code page table has 128 entries in PROGMEM, giving the unicode character for bytes 0x80 to 0xFF, the bytes
+     * below 0x80 are always ASCII. Bytes that the code page does not define map to 0xFFFD, the replacement character.
+     * To support another code page, provide a table of the same form to `setCodePage`.
+     */
+    /** Windows-1251, Cyrillic */
+    extern const uint16_t codePageWindows1251[128];
+    /** KOI8-R, Russian Cyrillic */
+    extern const uint16_t codePageKoi8R[128];
+    /** ISO-8859-2, Central European Latin */
+    extern const uint16_t codePageIso8859_2[128];
+}
+
+#endif //TCMENU_UTF8_CODE_PAGES_H
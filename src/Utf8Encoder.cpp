@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2018 https://www.thecoderscorner.com (Dave Cherry).
+ * This product is licensed under an Apache license, see the LICENSE file in the top-level directory.
+ */
+
+#include "Utf8Encoder.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define TC_UTF8_ENCODE_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define TC_UTF8_ENCODE_NEON
+#endif
+
+using namespace tccore;
+
+namespace {
+
+    /**
+     * Converts blocks of eight ASCII units from the start of the input, stopping at the first block that contains
+     * anything else or that would not fit in the output.
+     * @return the number of units converted, each one written as a single byte
+     */
+    size_t convertAsciiBlocks16(const uint16_t* in, size_t len, char* out, size_t outSize) {
+        size_t i = 0;
+#if defined(TC_UTF8_ENCODE_SSE2)
+        const __m128i notAscii = _mm_set1_epi16((short)0xFF80);
+        const __m128i zero = _mm_setzero_si128();
+        while (i + 8 <= len && i + 8 <= outSize) {
+            __m128i block = _mm_loadu_si128((const __m128i*)(in + i));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(block, notAscii), zero)) != 0xFFFF) break;
+            _mm_storel_epi64((__m128i*)(out + i), _mm_packus_epi16(block, block));
+            i += 8;
+        }
+#elif defined(TC_UTF8_ENCODE_NEON)
+        while (i + 8 <= len && i + 8 <= outSize) {
+            uint16x8_t block = vld1q_u16(in + i);
+            if (vmaxvq_u16(block) >= 0x80) break;
+            vst1_u8((uint8_t*)(out + i), vmovn_u16(block));
+            i += 8;
+        }
+#else
+        (void)in; (void)len; (void)out; (void)outSize;
+#endif
+        return i;
+    }
+
+    /**
+     * As convertAsciiBlocks16 but for UTF-32 input.
+     * @return the number of characters converted, each one written as a single byte
+     */
+    size_t convertAsciiBlocks32(const uint32_t* in, size_t len, char* out, size_t outSize) {
+        size_t i = 0;
+#if defined(TC_UTF8_ENCODE_SSE2)
+        const __m128i notAscii = _mm_set1_epi32((int)0xFFFFFF80);
+        const __m128i zero = _mm_setzero_si128();
+        while (i + 8 <= len && i + 8 <= outSize) {
+            __m128i low = _mm_loadu_si128((const __m128i*)(in + i));
+            __m128i high = _mm_loadu_si128((const __m128i*)(in + i + 4));
+            __m128i highBits = _mm_and_si128(_mm_or_si128(low, high), notAscii);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(highBits, zero)) != 0xFFFF) break;
+            __m128i words = _mm_packs_epi32(low, high);
+            _mm_storel_epi64((__m128i*)(out + i), _mm_packus_epi16(words, words));
+            i += 8;
+        }
+#elif defined(TC_UTF8_ENCODE_NEON)
+        while (i + 8 <= len && i + 8 <= outSize) {
+            uint32x4_t low = vld1q_u32(in + i);
+            uint32x4_t high = vld1q_u32(in + i + 4);
+            if (vmaxvq_u32(vorrq_u32(low, high)) >= 0x80) break;
+            uint16x8_t words = vcombine_u16(vmovn_u32(low), vmovn_u32(high));
+            vst1_u8((uint8_t*)(out + i), vmovn_u16(words));
+            i += 8;
+        }
+#else
+        (void)in; (void)len; (void)out; (void)outSize;
+#endif
+        return i;
+    }
+
+    bool isSurrogate(uint32_t ch) { return ch >= 0xD800 && ch <= 0xDFFF; }
+}
+
+size_t tccore::encodeUtf8(uint32_t ch, char* out) {
+    if (ch < 0x80) {
+        out[0] = (char)ch;
+        return 1;
+    } else if (ch < 0x800) {
+        out[0] = (char)(0xC0 | (ch >> 6));
+        out[1] = (char)(0x80 | (ch & 0x3F));
+        return 2;
+    }
+
+    if (isSurrogate(ch) || ch > 0x10FFFF) ch = TC_UNICODE_REPLACEMENT_CHAR;
+    if (ch < 0x10000) {
+        out[0] = (char)(0xE0 | (ch >> 12));
+        out[1] = (char)(0x80 | ((ch >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (ch & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (ch >> 18));
+    out[1] = (char)(0x80 | ((ch >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((ch >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (ch & 0x3F));
+    return 4;
+}
+
+Utf8TranscodeResult tccore::utf16ToUtf8(const uint16_t* in, size_t len, char* out, size_t outSize, bool finalChunk) {
+    size_t i = 0, written = 0;
+    while (i < len) {
+        if (in[i] < 0x80) {
+            size_t converted = convertAsciiBlocks16(in + i, len - i, out + written, outSize - written);
+            i += converted;
+            written += converted;
+            while (i < len && in[i] < 0x80 && written < outSize) out[written++] = (char)in[i++];
+            if (i == len || written == outSize) break;
+        }
+
+        uint32_t ch = in[i];
+        size_t units = 1;
+        // a high surrogate at the end may be paired with the first unit of the next chunk, so it is left for then.
+        if (ch >= 0xD800 && ch <= 0xDBFF && i + 1 == len && !finalChunk) break;
+        if (ch >= 0xD800 && ch <= 0xDBFF && i + 1 < len && in[i + 1] >= 0xDC00 && in[i + 1] <= 0xDFFF) {
+            ch = 0x10000 + ((ch - 0xD800) << 10) + (in[i + 1] - 0xDC00);
+            units = 2;
+        }
+        // an unpaired surrogate is left as it is, encodeUtf8 replaces it.
+        if (written + encodedUtf8Length(ch) > outSize) break;
+        written += encodeUtf8(ch, out + written);
+        i += units;
+    }
+    return Utf8TranscodeResult { i, written };
+}
+
+Utf8TranscodeResult tccore::utf32ToUtf8(const uint32_t* in, size_t len, char* out, size_t outSize) {
+    size_t i = 0, written = 0;
+    while (i < len) {
+        if (in[i] < 0x80) {
+            size_t converted = convertAsciiBlocks32(in + i, len - i, out + written, outSize - written);
+            i += converted;
+            written += converted;
+            while (i < len && in[i] < 0x80 && written < outSize) out[written++] = (char)in[i++];
+            if (i == len || written == outSize) break;
+        }
+
+        if (written + encodedUtf8Length(in[i]) > outSize) break;
+        written += encodeUtf8(in[i], out + written);
+        i++;
+    }
+    return Utf8TranscodeResult { i, written };
+}
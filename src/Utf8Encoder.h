@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2018 https://www.thecoderscorner.com (Dave Cherry).
+ * This product is licensed under an Apache license, see the LICENSE file in the top-level directory.
+ */
+
+#ifndef TCMENU_UTF8_ENCODER_H
+#define TCMENU_UTF8_ENCODER_H
+
+#include <string.h>
+#include <inttypes.h>
+
+/**
+ * @file Utf8Encoder.h
+ * @brief contains functions to encode unicode characters as UTF-8, and to transcode UTF-16 and UTF-32 text into UTF-8.
+ */
+
+/** the most bytes that encodeUtf8 will write for a single character */
+#define TC_UTF8_MAX_CHAR_BYTES 4
+
+/** the character written in place of anything that cannot be encoded, such as an unpaired surrogate */
+#define TC_UNICODE_REPLACEMENT_CHAR 0xFFFD
+
+namespace tccore {
+
+    /**
+     * The outcome of transcoding text into UTF-8
+     */
+    struct Utf8TranscodeResult {
+        /**
+         * the number of input units that were converted, less than the input length only when the output was full, or
+         * when utf16ToUtf8 is left holding a high surrogate at the end of a chunk that is not the final one
+         */
+        size_t consumed;
+        /** the number of bytes written to the output, the output is not zero terminated */
+        size_t written;
+    };
+
+    /**
+     * Encodes a single unicode character as UTF-8. Surrogates and anything above 0x10FFFF are not characters, and are
+     * written as the replacement character U+FFFD instead.
+     * @param ch the character to encode
+     * @param out receives the encoded bytes, it must have room for TC_UTF8_MAX_CHAR_BYTES
+     * @return the number of bytes written, from 1 to 4
+     */
+    size_t encodeUtf8(uint32_t ch, char* out);
+
+    /**
+     * @param ch the character to be encoded
+     * @return the number of bytes that encodeUtf8 will write for the character
+     */
+    inline size_t encodedUtf8Length(uint32_t ch) {
+        if (ch < 0x80) return 1;
+        if (ch < 0x800) return 2;
+        if (ch < 0x10000 || ch > 0x10FFFF) return 3;
+        return 4;
+    }
+
+    /**
+     * Transcodes UTF-16 text into UTF-8, surrogate pairs become a single four byte character, and unpaired surrogates are
+     * written as U+FFFD. Characters are never split, when the next one does not fit in the output, conversion stops
+     * there and the result says how much input was used, so the rest can be converted later. An output of three times
+     * the input length is always enough. When text arrives in chunks, pass finalChunk as false for all but the last,
+     * then a high surrogate that ends a chunk is not consumed, as its pair may start the next one, carry it over to the
+     * front of the next chunk. In the final chunk it is written as U+FFFD like any other unpaired surrogate. Runs of
+     * ASCII are converted several units at a time using SSE2 or NEON where available.
+     * @param in the UTF-16 text, in native byte order
+     * @param len the number of 16 bit units of text
+     * @param out the buffer that receives UTF-8
+     * @param outSize the size of the output buffer in bytes
+     * @param finalChunk true when the text ends with this chunk, false when more may follow
+     * @return the number of units consumed and bytes written
+     */
+    Utf8TranscodeResult utf16ToUtf8(const uint16_t* in, size_t len, char* out, size_t outSize, bool finalChunk = true);
+
+    /**
+     * Transcodes UTF-32 text into UTF-8, with the same rules for invalid characters and a full output as utf16ToUtf8.
+     * An output of four times the input length is always enough.
+     * @param in the UTF-32 text, in native byte order
+     * @param len the number of characters of text
+     * @param out the buffer that receives UTF-8
+     * @param outSize the size of the output buffer in bytes
+     * @return the number of characters consumed and bytes written
+     */
+    Utf8TranscodeResult utf32ToUtf8(const uint32_t* in, size_t len, char* out, size_t outSize);
+}
+
+#endif //TCMENU_UTF8_ENCODER_H
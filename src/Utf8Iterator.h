@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2018 https://www.thecoderscorner.com (Dave Cherry).
+ * This product is licensed under an Apache license, see the LICENSE file in the top-level directory.
+ */
+
+#ifndef TCMENU_UTF8_ITERATOR_H
+#define TCMENU_UTF8_ITERATOR_H
+
+#include <string.h>
+#include <inttypes.h>
+#include "Utf8TextProcessor.h"
+
+/**
+ * @file Utf8Iterator.h
+ * @brief contains a pull style UTF-8 iterator and view, that decode lazily without any memory allocation.
+ */
+
+namespace tccore {
+
+    /**
+     * Reads UTF-8 text held in RAM, this is the default reader policy for the iterator.
+     */
+    struct Utf8RamReader {
+        static uint8_t read(const char* ptr) { return (uint8_t)*ptr; }
+        static size_t length(const char* str) { return strlen(str); }
+    };
+
+    /**
+     * Reads UTF-8 text held in PROGMEM, on boards where program memory is directly addressable this is the same as
+     * reading from RAM.
+     */
+    struct Utf8ProgmemReader {
+        static uint8_t read(const char* ptr) { return TC_UTF8_PGM_READ_BYTE((const uint8_t*)ptr); }
+        static size_t length(const char* str) {
+            size_t len = 0;
+            while (read(str + len) != 0) len++;
+            return len;
+        }
+    };
+
+    /**
+     * An iterator that decodes one character each time it is advanced, yielding exactly the same characters and
+     * `TC_UNICODE_CHAR_ERROR` markers as Utf8TextProcessor would for the same bytes, and also an error for a sequence
+     * cut short by the end of the text. Iterators are small values, so copy one to remember a position and come back to
+     * it later, for example to measure a line before drawing it.
+     * @tparam Reader the policy used to read bytes, either Utf8RamReader or Utf8ProgmemReader
+     */
+    template<typename Reader> class BasicUtf8Iterator {
+    private:
+        const char* data;
+        size_t len;
+        size_t pos;
+        size_t nextPos;
+        uint32_t current;
+    public:
+        /**
+         * Create an iterator positioned at a byte offset in the data, the offset should be at the start of a character,
+         * use the position of another iterator or 0.
+         * @param data the UTF-8 data
+         * @param len the number of bytes of data
+         * @param position the byte offset to start from
+         */
+        BasicUtf8Iterator(const char* data, size_t len, size_t position) : data(data), len(len), pos(position),
+                                                                           nextPos(position), current(0) {
+            decode();
+        }
+
+        /** @return the character at this position, or TC_UNICODE_CHAR_ERROR */
+        uint32_t operator*() const { return current; }
+
+        /** move on to the next character */
+        BasicUtf8Iterator& operator++() {
+            pos = nextPos;
+            decode();
+            return *this;
+        }
+
+        bool operator==(const BasicUtf8Iterator& other) const { return pos == other.pos && data == other.data; }
+        bool operator!=(const BasicUtf8Iterator& other) const { return !(*this == other); }
+
+        /** @return the byte offset of the current character within the data */
+        size_t position() const { return pos; }
+
+        /** @return the byte offset just after the current character, where the next one starts */
+        size_t nextPosition() const { return nextPos; }
+
+        /** @return true once all the data has been read */
+        bool atEnd() const { return pos >= len; }
+
+    private:
+        bool isContinuation(uint8_t b) const { return (b & 0xC0) == 0x80; }
+
+        void decode() {
+            if (pos >= len) {
+                nextPos = pos = len;
+                return;
+            }
+
+            uint8_t lead = Reader::read(data + pos);
+            nextPos = pos + 1;
+            int extraChars;
+            if (lead < 0x80) {
+                current = lead;
+                return;
+            } else if ((lead & 0xE0) == 0xC0) {
+                current = lead & 0x1FU;
+                extraChars = 1;
+            } else if ((lead & 0xF0) == 0xE0) {
+                current = lead & 0x0FU;
+                extraChars = 2;
+            } else if ((lead & 0xF8) == 0xF0) {
+                current = lead & 0x07U;
+                extraChars = 3;
+            } else {
+                // continuation bytes and anything that can never start a sequence are errors on their own.
+                current = TC_UNICODE_CHAR_ERROR;
+                return;
+            }
+
+            for (int i = 0; i < extraChars; i++, nextPos++) {
+                if (nextPos >= len) {
+                    current = TC_UNICODE_CHAR_ERROR;
+                    return;
+                }
+                uint8_t b = Reader::read(data + nextPos);
+                if (!isContinuation(b)) {
+                    // as with the decoder, the byte that broke the sequence starts the next character, unless it can
+                    // never be passed on, in which case it is part of this error.
+                    if (b == 0 || b == 0xFE || b == 0xFF) nextPos++;
+                    current = TC_UNICODE_CHAR_ERROR;
+                    return;
+                }
+                current = (current << 6) | (b & 0x3FU);
+            }
+
+            bool overlong = current < 0x80 || (current < 0x800 && extraChars > 1) ||
+                            (current < 0x10000 && extraChars > 2);
+            if (overlong) current = TC_UNICODE_CHAR_ERROR;
+        }
+    };
+
+    /**
+     * A view over UTF-8 text that can be used in a range based for loop, giving each character in turn, for example
+     * `for (uint32_t ch : Utf8View("Привіт")) { ... }`. Nothing is decoded until the view is iterated, and it can be
+     * iterated as many times as needed.
+     * @tparam Reader the policy used to read bytes, either Utf8RamReader or Utf8ProgmemReader
+     */
+    template<typename Reader> class BasicUtf8View {
+    private:
+        const char* text;
+        size_t len;
+    public:
+        /**
+         * Create a view over a zero terminated string
+         * @param str the string, in RAM or PROGMEM depending on the reader
+         */
+        explicit BasicUtf8View(const char* str) : text(str), len(Reader::length(str)) {}
+
+        /**
+         * Create a view over a known number of bytes
+         * @param data the UTF-8 data, in RAM or PROGMEM depending on the reader
+         * @param len the number of bytes of data
+         */
+        BasicUtf8View(const char* data, size_t len) : text(data), len(len) {}
+
+        BasicUtf8Iterator<Reader> begin() const { return BasicUtf8Iterator<Reader>(text, len, 0); }
+        BasicUtf8Iterator<Reader> end() const { return BasicUtf8Iterator<Reader>(text, len, len); }
+
+        /**
+         * @param position a byte offset that starts a character, such as the position of an earlier iterator
+         * @return an iterator that continues from the position
+         */
+        BasicUtf8Iterator<Reader> from(size_t position) const { return BasicUtf8Iterator<Reader>(text, len, position); }
+
+        /** @return the data that the view is over */
+        const char* data() const { return text; }
+
+        /** @return the number of bytes in the view */
+        size_t size() const { return len; }
+    };
+
+    typedef BasicUtf8Iterator<Utf8RamReader> Utf8Iterator;
+    typedef BasicUtf8View<Utf8RamReader> Utf8View;
+    typedef BasicUtf8Iterator<Utf8ProgmemReader> Utf8ProgmemIterator;
+    typedef BasicUtf8View<Utf8ProgmemReader> Utf8ProgmemView;
+}
+
+#endif //TCMENU_UTF8_ITERATOR_H
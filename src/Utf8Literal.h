@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2018 https://www.thecoderscorner.com (Dave Cherry).
+ * This product is licensed under an Apache license, see the LICENSE file in the top-level directory.
+ */
+
+#ifndef TCMENU_UTF8_LITERAL_H
+#define TCMENU_UTF8_LITERAL_H
+
+#include <stddef.h>
+#include <inttypes.h>
+
+/**
+ * @file Utf8Literal.h
+ * @brief contains a C++17 facility that decodes UTF-8 string literals into arrays of characters at compile time.
+ *
+ * Text that never changes, such as menu labels, can be decoded once by the compiler and then drawn with
+ * `UnicodeFontHandler::printCodePoints` without any decoding at runtime:
+ *
+ *     constexpr auto helloLabel = TC_UTF8_LITERAL("Привіт Світ");
+ *     fontHandler.printCodePoints(helloLabel.data(), helloLabel.size());
+ *
+ * A literal that is not valid UTF-8, by the same rules as Utf8TextProcessor, fails to compile.
+ */
+
+#if __cplusplus >= 201703L
+
+namespace tccore {
+
+    /**
+     * An array of characters decoded from a UTF-8 literal, usually created with TC_UTF8_LITERAL.
+     * @tparam N the number of characters
+     */
+    template<size_t N> struct Utf8Literal {
+        uint32_t chars[N > 0 ? N : 1];
+
+        constexpr const uint32_t* data() const { return chars; }
+        constexpr size_t size() const { return N; }
+        constexpr const uint32_t* begin() const { return chars; }
+        constexpr const uint32_t* end() const { return chars + N; }
+        constexpr uint32_t operator[](size_t idx) const { return chars[idx]; }
+    };
+
+    namespace literal_detail {
+        /**
+         * Not constexpr on purpose, reaching this while decoding at compile time stops the compile, which is how an
+         * invalid literal is reported. The compiler error will point here, with the literal further up.
+         */
+        inline void invalidUtf8InLiteral() {}
+
+        /**
+         * Decodes the character starting at pos, by the same rules as Utf8TextProcessor.
+         * @param len receives the number of bytes in the character
+         * @return the character
+         */
+        template<size_t N> constexpr uint32_t decodeAt(const char (&str)[N], size_t pos, size_t& len) {
+            uint8_t lead = (uint8_t)str[pos];
+            int extraChars = 0;
+            uint32_t ch = 0;
+            if (lead < 0x80) {
+                len = 1;
+                return lead;
+            } else if ((lead & 0xE0) == 0xC0) {
+                ch = lead & 0x1FU;
+                extraChars = 1;
+            } else if ((lead & 0xF0) == 0xE0) {
+                ch = lead & 0x0FU;
+                extraChars = 2;
+            } else if ((lead & 0xF8) == 0xF0) {
+                ch = lead & 0x07U;
+                extraChars = 3;
+            } else {
+                invalidUtf8InLiteral();
+            }
+
+            for (int i = 1; i <= extraChars; i++) {
+                // the terminator is never a continuation, so this also stops at the end of the literal.
+                uint8_t data = (uint8_t)str[pos + i];
+                if ((data & 0xC0) != 0x80) invalidUtf8InLiteral();
+                ch = (ch << 6) | (data & 0x3FU);
+            }
+            if (ch < 0x80 || (ch < 0x800 && extraChars > 1) || (ch < 0x10000 && extraChars > 2)) {
+                invalidUtf8InLiteral();
+            }
+            len = extraChars + 1;
+            return ch;
+        }
+    }
+
+    /**
+     * @param str a UTF-8 string literal
+     * @return the number of characters in the literal, it is a compile error if it is not valid UTF-8
+     */
+    template<size_t N> constexpr size_t utf8LiteralLength(const char (&str)[N]) {
+        size_t count = 0;
+        for (size_t pos = 0; pos + 1 < N;) {
+            size_t len = 0;
+            literal_detail::decodeAt(str, pos, len);
+            pos += len;
+            count++;
+        }
+        return count;
+    }
+
+    /**
+     * Decodes a UTF-8 string literal into an array of characters, normally used through TC_UTF8_LITERAL, which works
+     * out the number of characters for you.
+     * @tparam Count the number of characters in the literal, from utf8LiteralLength
+     * @param str a UTF-8 string literal
+     * @return the decoded characters
+     */
+    template<size_t Count, size_t N> constexpr Utf8Literal<Count> utf8DecodeLiteral(const char (&str)[N]) {
+        Utf8Literal<Count> decoded {};
+        size_t count = 0;
+        for (size_t pos = 0; pos + 1 < N && count < Count;) {
+            size_t len = 0;
+            decoded.chars[count++] = literal_detail::decodeAt(str, pos, len);
+            pos += len;
+        }
+        return decoded;
+    }
+}
+
+/**
+ * Decodes a UTF-8 string literal at compile time into a tccore::Utf8Literal holding exactly its characters, use it to
+ * initialise a constexpr variable. A literal that is not valid UTF-8 fails to compile.
+ */
+#define TC_UTF8_LITERAL(str) (::tccore::utf8DecodeLiteral<::tccore::utf8LiteralLength(str)>(str))
+
+#endif // C++17
+
+#endif //TCMENU_UTF8_LITERAL_H
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2018 https://www.thecoderscorner.com (Dave Cherry).
+ * This product is licensed under an Apache license, see the LICENSE file in the top-level directory.
+ */
+
+#ifndef TCMENU_UTF8_PACKED_DECODER_H
+#define TCMENU_UTF8_PACKED_DECODER_H
+
+#include <string.h>
+#include <inttypes.h>
+#include "Utf8TextProcessor.h"
+
+/**
+ * @file Utf8PackedDecoder.h
+ * @brief contains a UTF-8 decoder whose whole state packs into 4 bytes, for when there are very many streams at once.
+ */
+
+/** the state that a packed decoder starts in, and returns to between sequences */
+#define TC_UTF8_PACKED_INITIAL_STATE 0U
+
+namespace tccore {
+
+    /**
+     * The complete state of a packed decoder, the low four bits are the state of the table driven decoder and the rest
+     * hold the character so far. Start each stream at TC_UTF8_PACKED_INITIAL_STATE, nothing else is needed per stream.
+     */
+    typedef uint32_t Utf8PackedState;
+
+    /**
+     * @param state a packed decoder state
+     * @return true when the stream is not part way through a sequence
+     */
+    inline bool utf8PackedBetweenSequences(Utf8PackedState state) {
+        return (state & utf8table::TRN_STATE_MASK) == utf8table::TST_ACCEPT;
+    }
+
+    /**
+     * Decodes more data for one stream, carrying on from its packed state, with exactly the same rules as
+     * ENCMODE_UTF8_TABLE. The handler is not part of the state, so one handler can serve all streams, given whatever
+     * identifies the stream by capture or user data. Runs of ASCII go straight to the handler between sequences.
+     * @param state the state of the stream, from the last call or TC_UTF8_PACKED_INITIAL_STATE
+     * @param data the data that arrived for the stream, a sequence may be split between calls
+     * @param len the number of bytes of data
+     * @param handler called as `handler(uint32_t ch)` for each character or TC_UNICODE_CHAR_ERROR
+     * @return the new state to store for the stream
+     */
+    template<typename Handler> Utf8PackedState utf8Resume(Utf8PackedState state, const char* data, size_t len,
+                                                          Handler handler) {
+        uint8_t tableState = state & utf8table::TRN_STATE_MASK;
+        uint32_t current = state >> 4;
+        size_t i = 0;
+        while (i < len) {
+            if (tableState == utf8table::TST_ACCEPT) {
+                size_t asciiEnd = i + utf8AsciiPrefixLength(data + i, len - i);
+                while (i < asciiEnd) handler((uint32_t)(uint8_t)data[i++]);
+                if (i == len) break;
+            }
+            utf8table::advance(tableState, current, (uint8_t)data[i++], handler);
+        }
+        // a part character needs at most 15 bits, and once a character is complete there is nothing to keep.
+        return (tableState == utf8table::TST_ACCEPT) ? TC_UTF8_PACKED_INITIAL_STATE : ((current << 4) | tableState);
+    }
+
+    /**
+     * Decodes more data for one stream with a function pointer handler, see the template version.
+     * @param state the state of the stream, from the last call or TC_UTF8_PACKED_INITIAL_STATE
+     * @param data the data that arrived for the stream
+     * @param len the number of bytes of data
+     * @param handler the callback that receives characters
+     * @param userData passed back to the callback, for example to say which stream the characters are from
+     * @return the new state to store for the stream
+     */
+    inline Utf8PackedState utf8Resume(Utf8PackedState state, const char* data, size_t len,
+                                      UnicodeCharacterHandler handler, void* userData) {
+        return utf8Resume(state, data, len, Utf8CallbackHandler{handler, userData});
+    }
+
+    /**
+     * Ends a stream, reporting an error if it stopped part way through a sequence.
+     * @param state the state of the stream
+     * @param handler called with TC_UNICODE_CHAR_ERROR if the stream ended part way through a sequence
+     * @return the initial state, ready for the stream to be reused
+     */
+    template<typename Handler> Utf8PackedState utf8Finish(Utf8PackedState state, Handler handler) {
+        if (!utf8PackedBetweenSequences(state)) handler(TC_UNICODE_CHAR_ERROR);
+        return TC_UTF8_PACKED_INITIAL_STATE;
+    }
+}
+
+#endif //TCMENU_UTF8_PACKED_DECODER_H
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2018 https://www.thecoderscorner.com (Dave Cherry).
+ * This product is licensed under an Apache license, see the LICENSE file in the top-level directory.
+ */
+
+#include "Utf8ParallelDecoder.h"
+
+#ifdef TC_UTF8_HAS_PARALLEL_DECODE
+
+#include <thread>
+#include <vector>
+
+using namespace tccore;
+
+namespace {
+
+    struct DecodeChunk {
+        size_t start;
+        size_t end;
+        Utf8DecodeResult result;
+        size_t firstError;      // where the positions of this chunk's errors start in the caller's array
+        size_t positionsWanted; // how many of this chunk's error positions fit in the caller's array
+    };
+
+    /**
+     * Decodes each chunk on its own thread, into the output at the chunk's own offset, there is always room as no
+     * chunk writes more than it reads. When positions are wanted, each chunk writes them straight into its part of
+     * the caller's array, relative to the start of the chunk.
+     */
+    void decodeChunks(std::vector<DecodeChunk>& chunks, const uint8_t* in, uint32_t* out, size_t* errorPositions) {
+        std::vector<std::thread> workers;
+        for (auto& chunk : chunks) {
+            if (errorPositions != nullptr && chunk.positionsWanted == 0) continue;
+            workers.emplace_back([&chunk, in, out, errorPositions]() {
+                size_t* positions = (errorPositions != nullptr) ? errorPositions + chunk.firstError : nullptr;
+                chunk.result = decodeUtf8(in + chunk.start, chunk.end - chunk.start, out + chunk.start, positions,
+                                          chunk.positionsWanted);
+            });
+        }
+        for (auto& worker : workers) worker.join();
+    }
+
+    /**
+     * A byte is somewhere the decoder starts afresh when it cannot continue an earlier sequence. Were the decoder part
+     * way through one, it would report the error and then process this byte from the start, which is just what happens
+     * when the chunk before ends with an incomplete sequence. Nul and 0xFE/0xFF are the exceptions, they end a broken
+     * sequence without being processed again.
+     */
+    bool isSplitPoint(uint8_t data) {
+        return (data & 0xC0) != 0x80 && data != 0 && data != 0xFE && data != 0xFF;
+    }
+
+    /**
+     * @return true if the chunk ends part way through a sequence, which decodeUtf8 reports as a final error
+     */
+    bool endsPartWay(const uint8_t* in, size_t start, size_t end) {
+        size_t continuations = 0;
+        while (end > start && continuations < 4) {
+            uint8_t data = in[--end];
+            if ((data & 0xC0) != 0x80) {
+                size_t needed = (data & 0xE0) == 0xC0 ? 1 : (data & 0xF0) == 0xE0 ? 2 : (data & 0xF8) == 0xF0 ? 3 : 0;
+                return continuations < needed;
+            }
+            continuations++;
+        }
+        return false;
+    }
+}
+
+Utf8DecodeResult tccore::decodeUtf8Parallel(const uint8_t* in, size_t len, uint32_t* out, size_t* errorPositions,
+                                            size_t maxErrorPositions, unsigned threads) {
+    if (errorPositions == nullptr) maxErrorPositions = 0;
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    if (threads > len / TC_UTF8_PARALLEL_MIN_CHUNK) threads = (unsigned)(len / TC_UTF8_PARALLEL_MIN_CHUNK);
+    if (threads <= 1) return decodeUtf8(in, len, out, errorPositions, maxErrorPositions);
+
+    // split as evenly as possible, moving each split forward to the next place the decoder starts afresh.
+    std::vector<DecodeChunk> chunks;
+    size_t start = 0;
+    for (unsigned i = 1; i <= threads && start < len; i++) {
+        size_t end = (i == threads) ? len : (len / threads) * i;
+        if (end < start) end = start;
+        while (end < len && !isSplitPoint(in[end])) end++;
+        if (end == start) continue;
+        chunks.push_back(DecodeChunk { start, end, {0, 0}, 0, 0 });
+        start = end;
+    }
+
+    // the first pass only counts the errors, so no chunk needs room for positions that may never be used.
+    decodeChunks(chunks, in, out, nullptr);
+
+    // with the counts known, only the chunks holding the first maxErrorPositions errors are decoded again, writing
+    // their positions straight into the caller's array. Valid text has no errors and so is only decoded once.
+    size_t errorsBefore = 0;
+    for (auto& chunk : chunks) {
+        chunk.firstError = errorsBefore;
+        size_t room = (errorsBefore < maxErrorPositions) ? maxErrorPositions - errorsBefore : 0;
+        chunk.positionsWanted = chunk.result.errorCount < room ? chunk.result.errorCount : room;
+        errorsBefore += chunk.result.errorCount;
+    }
+    if (maxErrorPositions != 0 && errorsBefore != 0) decodeChunks(chunks, in, out, errorPositions);
+
+    Utf8DecodeResult result = {0, 0};
+    for (size_t i = 0; i < chunks.size(); i++) {
+        auto& chunk = chunks[i];
+        if (chunk.start != result.written) {
+            memmove(out + result.written, out + chunk.start, chunk.result.written * sizeof(uint32_t));
+        }
+        result.written += chunk.result.written;
+
+        size_t recorded = chunk.positionsWanted;
+        if (recorded > 0) {
+            size_t* positions = errorPositions + chunk.firstError;
+            if (recorded == chunk.result.errorCount && i + 1 < chunks.size() && endsPartWay(in, chunk.start, chunk.end)) {
+                // in one pass the incomplete sequence is found at the byte that breaks it, the first of the next chunk.
+                positions[recorded - 1] = chunk.end - chunk.start;
+            }
+            for (size_t e = 0; e < recorded; e++) positions[e] += chunk.start;
+        }
+        result.errorCount += chunk.result.errorCount;
+    }
+    return result;
+}
+
+#endif // TC_UTF8_HAS_PARALLEL_DECODE
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2018 https://www.thecoderscorner.com (Dave Cherry).
+ * This product is licensed under an Apache license, see the LICENSE file in the top-level directory.
+ */
+
+#ifndef TCMENU_UTF8_PARALLEL_DECODER_H
+#define TCMENU_UTF8_PARALLEL_DECODER_H
+
+#include "Utf8BulkDecoder.h"
+
+/**
+ * @file Utf8ParallelDecoder.h
+ * @brief contains a multi threaded version of the bulk UTF-8 decoder for very large buffers on host builds.
+ */
+
+#if !defined(ARDUINO) && !defined(__MBED__) && !defined(BUILD_FOR_PICO_CMAKE) && __has_include(<thread>)
+#define TC_UTF8_HAS_PARALLEL_DECODE
+
+/** buffers are only split when each thread would get at least this many bytes, below it threads cost more than they save */
+#ifndef TC_UTF8_PARALLEL_MIN_CHUNK
+#define TC_UTF8_PARALLEL_MIN_CHUNK 65536
+#endif
+
+namespace tccore {
+
+    /**
+     * Decodes a large buffer of UTF-8 using several threads, giving exactly the same output, error count and error
+     * positions as `decodeUtf8`. The buffer is split where the decoder is certain to start afresh, on a byte that
+     * cannot be part of an earlier sequence, each piece is decoded on its own thread into its own part of the output,
+     * and then the pieces are joined up in order. Small buffers are decoded on the calling thread. When there are errors
+     * and positions are wanted, the pieces holding the first maxErrorPositions errors are decoded a second time to fill
+     * them in, so no extra memory is needed for them.
+     *
+     * @param in the UTF-8 data, for example a memory mapped file
+     * @param len the number of bytes of data
+     * @param out receives the code points and error markers, it must have room for at least len entries.
+     * @param errorPositions optionally receives the byte offset of each error, as with decodeUtf8. Can be nullptr.
+     * @param maxErrorPositions the number of entries available in errorPositions
+     * @param threads the number of threads to use, 0 to use one per hardware thread
+     * @return the number of entries written and the number of errors
+     */
+    Utf8DecodeResult decodeUtf8Parallel(const uint8_t* in, size_t len, uint32_t* out, size_t* errorPositions = nullptr,
+                                        size_t maxErrorPositions = 0, unsigned threads = 0);
+}
+
+#endif // host with threads
+
+#endif //TCMENU_UTF8_PARALLEL_DECODER_H
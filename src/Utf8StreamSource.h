@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2018 https://www.thecoderscorner.com (Dave Cherry).
+ * This product is licensed under an Apache license, see the LICENSE file in the top-level directory.
+ */
+
+#ifndef TCMENU_UTF8_STREAM_SOURCE_H
+#define TCMENU_UTF8_STREAM_SOURCE_H
+
+#include <string.h>
+#include <inttypes.h>
+#include "Utf8TextProcessor.h"
+
+/**
+ * @file Utf8StreamSource.h
+ * @brief contains adapters that read text from an Arduino Stream, or a file descriptor on a host, straight into the
+ * UTF-8 decoder in chunks.
+ */
+
+/** the size of the buffer on the stack used to read each chunk from a stream */
+#ifndef TC_UTF8_STREAM_CHUNK_SIZE
+#define TC_UTF8_STREAM_CHUNK_SIZE 32
+#endif
+
+#if !defined(ARDUINO) && (defined(__unix__) || defined(__APPLE__)) && __has_include(<unistd.h>) && __has_include(<sys/ioctl.h>)
+#include <unistd.h>
+#include <sys/ioctl.h>
+#define TC_UTF8_HAS_FD_SOURCE
+#endif
+
+namespace tccore {
+
+    /**
+     * Reads whatever is available from a source, a chunk at a time, and passes each chunk on to the consumer. It never
+     * waits for data that has not arrived, so call it again each time around the loop. Nothing is lost when a sequence
+     * is split between chunks, as the decoder keeps its state between calls.
+     * @tparam Source anything with `int available()` and `size_t readBytes(char*, size_t)`, such as an Arduino Stream
+     * @tparam Consumer called as `consumer(const char* data, size_t len)` for each chunk
+     * @param source the source to read from
+     * @param consumer the consumer of each chunk
+     * @param maxBytes the most bytes to read in this call
+     * @return the number of bytes read
+     */
+    template<typename Source, typename Consumer> size_t utf8DrainSource(Source& source, Consumer consumer,
+                                                                        size_t maxBytes = (size_t)-1) {
+        char chunk[TC_UTF8_STREAM_CHUNK_SIZE];
+        size_t total = 0;
+        int available;
+        while (total < maxBytes && (available = source.available()) > 0) {
+            size_t wanted = (size_t)available < sizeof(chunk) ? (size_t)available : sizeof(chunk);
+            if (wanted > maxBytes - total) wanted = maxBytes - total;
+            size_t actual = source.readBytes(chunk, wanted);
+            if (actual == 0) break;
+            consumer(chunk, actual);
+            total += actual;
+        }
+        return total;
+    }
+
+    /**
+     * Reads whatever is available from a source straight into a decoder, see utf8DrainSource.
+     * @param source the source to read from, such as an Arduino Stream
+     * @param processor the decoder to push the data into
+     * @param maxBytes the most bytes to read in this call
+     * @return the number of bytes read
+     */
+    template<typename Source, typename Handler> size_t utf8DrainIntoDecoder(Source& source,
+                                                                           BasicUtf8TextProcessor<Handler>& processor,
+                                                                           size_t maxBytes = (size_t)-1) {
+        return utf8DrainSource(source, [&processor](const char* data, size_t len) {
+            processor.pushChars(data, len);
+        }, maxBytes);
+    }
+
+#ifdef TC_UTF8_HAS_FD_SOURCE
+    /**
+     * On host builds, presents a file descriptor such as a pipe, socket or serial device as a source for
+     * utf8DrainSource, with the same available and readBytes functions as an Arduino Stream.
+     */
+    class Utf8FileDescriptorSource {
+    private:
+        int fd;
+    public:
+        explicit Utf8FileDescriptorSource(int fd) : fd(fd) {}
+
+        /** @return the number of bytes that can be read without waiting */
+        int available() {
+            int waiting = 0;
+            return (ioctl(fd, FIONREAD, &waiting) == 0) ? waiting : 0;
+        }
+
+        size_t readBytes(char* buffer, size_t len) {
+            ssize_t actual = read(fd, buffer, len);
+            return actual > 0 ? (size_t)actual : 0;
+        }
+    };
+#endif
+}
+
+#endif //TCMENU_UTF8_STREAM_SOURCE_H
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2018 https://www.thecoderscorner.com (Dave Cherry).
+ * This product is licensed under an Apache license, see the LICENSE file in the top-level directory.
+ */
+
+#include "Utf8StringUtils.h"
+#include "Utf8TextProcessor.h"
+#include "Utf8Iterator.h"
+
+using namespace tccore;
+
+size_t tccore::utf8CountCharacters(const char* data, size_t len) {
+    size_t pos = 0, count = 0;
+    while (pos < len) {
+        size_t asciiRun = utf8AsciiPrefixLength(data + pos, len - pos);
+        count += asciiRun;
+        pos += asciiRun;
+        if (pos == len) break;
+
+        Utf8Iterator it(data, len, pos);
+        count++;
+        pos = it.nextPosition();
+    }
+    return count;
+}
+
+size_t tccore::utf8OffsetOfCharacter(const char* data, size_t len, size_t index) {
+    size_t pos = 0, count = 0;
+    while (pos < len) {
+        size_t asciiRun = utf8AsciiPrefixLength(data + pos, len - pos);
+        if (index < count + asciiRun) return pos + (index - count);
+        count += asciiRun;
+        pos += asciiRun;
+        if (pos == len) break;
+
+        if (count == index) return pos;
+        Utf8Iterator it(data, len, pos);
+        count++;
+        pos = it.nextPosition();
+    }
+    return len;
+}
+
+size_t tccore::utf8TruncatedLength(const char* data, size_t len, size_t maxBytes) {
+    if (len <= maxBytes) return len;
+
+    size_t pos = 0;
+    while (pos < maxBytes) {
+        // all of the ascii up to the limit fits, as each byte is a character.
+        size_t asciiRun = utf8AsciiPrefixLength(data + pos, maxBytes - pos);
+        pos += asciiRun;
+        if (pos == maxBytes) break;
+
+        Utf8Iterator it(data, len, pos);
+        if (it.nextPosition() > maxBytes) break;
+        pos = it.nextPosition();
+    }
+    return pos;
+}
+
+size_t tccore::utf8CopyTruncated(char* dest, size_t destSize, const char* src) {
+    size_t toCopy = utf8TruncatedLength(src, strlen(src), destSize - 1);
+    memcpy(dest, src, toCopy);
+    dest[toCopy] = 0;
+    return toCopy;
+}
+
+bool tccore::utf8IsValid(const char* data, size_t len, size_t* errorOffset) {
+    size_t pos = 0;
+    while (pos < len) {
+        pos += utf8AsciiPrefixLength(data + pos, len - pos);
+        if (pos == len) break;
+
+        Utf8Iterator it(data, len, pos);
+        if (*it == TC_UNICODE_CHAR_ERROR) {
+            if (errorOffset) *errorOffset = pos;
+            return false;
+        }
+        pos = it.nextPosition();
+    }
+    return true;
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2018 https://www.thecoderscorner.com (Dave Cherry).
+ * This product is licensed under an Apache license, see the LICENSE file in the top-level directory.
+ */
+
+#ifndef TCMENU_UTF8_STRING_UTILS_H
+#define TCMENU_UTF8_STRING_UTILS_H
+
+#include <string.h>
+#include <inttypes.h>
+
+/**
+ * @file Utf8StringUtils.h
+ * @brief contains functions for measuring, clipping and validating UTF-8 text without a decoder callback.
+ *
+ * These all follow the rules of Utf8TextProcessor, so a character is exactly what the decoder would deliver, and each
+ * error the decoder would report also counts as one character. Runs of ASCII are skipped a machine word at a time.
+ */
+
+namespace tccore {
+
+    /**
+     * @param data the UTF-8 text
+     * @param len the number of bytes of text
+     * @return the number of characters in the text, each error counting as one
+     */
+    size_t utf8CountCharacters(const char* data, size_t len);
+
+    /**
+     * Finds where a character starts, for example to skip the first few characters of a string.
+     * @param data the UTF-8 text
+     * @param len the number of bytes of text
+     * @param index the zero based index of the character
+     * @return the byte offset at which the character starts, or len when there are not that many characters
+     */
+    size_t utf8OffsetOfCharacter(const char* data, size_t len, size_t index);
+
+    /**
+     * Finds the longest length of the text that fits within a number of bytes without splitting a character.
+     * @param data the UTF-8 text
+     * @param len the number of bytes of text
+     * @param maxBytes the number of bytes available
+     * @return the number of bytes to keep, len if it all fits
+     */
+    size_t utf8TruncatedLength(const char* data, size_t len, size_t maxBytes);
+
+    /**
+     * Copies a zero terminated string into a fixed size buffer, cutting it short on a character boundary if needed, the
+     * result is always zero terminated.
+     * @param dest the buffer to copy into
+     * @param destSize the size of the buffer including room for the terminator, must be at least 1
+     * @param src the zero terminated UTF-8 string to copy
+     * @return the number of bytes copied, not including the terminator
+     */
+    size_t utf8CopyTruncated(char* dest, size_t destSize, const char* src);
+
+    /**
+     * Checks that text contains no errors at all, including a sequence cut short at the end.
+     * @param data the UTF-8 text
+     * @param len the number of bytes of text
+     * @param errorOffset optionally receives the byte offset of the first character that is in error, can be nullptr
+     * @return true if the text is entirely valid, otherwise false
+     */
+    bool utf8IsValid(const char* data, size_t len, size_t* errorOffset = nullptr);
+}
+
+#endif //TCMENU_UTF8_STRING_UTILS_H
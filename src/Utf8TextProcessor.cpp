@@ -5,126 +5,89 @@
 
 #include "Utf8TextProcessor.h"
 
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+
 using namespace tccore;
+using namespace tccore::utf8table;
 
-void Utf8TextProcessor::reset() {
-    // clear the text buffer
-    extraCharsNeeded = 0;
-    decoderState = WAITING_BYTE_0;
-}
+template class tccore::BasicUtf8TextProcessor<Utf8CallbackHandler>;
 
-void Utf8TextProcessor::pushChars(const char *str) {
-    while (*str) {
-        pushChar(*str);
-        str++;
-    }
-}
+// the table driven decoder first sorts each byte into a class, and then looks up the class in a row per state.
+const uint8_t tccore::utf8table::byteClasses[256] PROGMEM = {
+    CLS_NUL, CLS_ASCII, CLS_ASCII, CLS_ASCII, CLS_ASCII, CLS_ASCII, CLS_ASCII, CLS_ASCII,
+#define TC_UTF8_CLASS_8(c) c, c, c, c, c, c, c, c
+#define TC_UTF8_CLASS_16(c) TC_UTF8_CLASS_8(c), TC_UTF8_CLASS_8(c)
+    TC_UTF8_CLASS_8(CLS_ASCII), TC_UTF8_CLASS_16(CLS_ASCII),                        // 0x08 - 0x1F
+    TC_UTF8_CLASS_16(CLS_ASCII), TC_UTF8_CLASS_16(CLS_ASCII),                       // 0x20 - 0x3F
+    TC_UTF8_CLASS_16(CLS_ASCII), TC_UTF8_CLASS_16(CLS_ASCII),                       // 0x40 - 0x5F
+    TC_UTF8_CLASS_16(CLS_ASCII), TC_UTF8_CLASS_16(CLS_ASCII),                       // 0x60 - 0x7F
+    TC_UTF8_CLASS_16(CLS_CONT_80_8F), TC_UTF8_CLASS_16(CLS_CONT_90_9F),             // 0x80 - 0x9F
+    TC_UTF8_CLASS_16(CLS_CONT_A0_BF), TC_UTF8_CLASS_16(CLS_CONT_A0_BF),             // 0xA0 - 0xBF
+    CLS_LEAD_C0_C1, CLS_LEAD_C0_C1, CLS_LEAD_C2_DF, CLS_LEAD_C2_DF,                 // 0xC0 - 0xC3
+    CLS_LEAD_C2_DF, CLS_LEAD_C2_DF, CLS_LEAD_C2_DF, CLS_LEAD_C2_DF,                 // 0xC4 - 0xC7
+    TC_UTF8_CLASS_8(CLS_LEAD_C2_DF), TC_UTF8_CLASS_16(CLS_LEAD_C2_DF),              // 0xC8 - 0xDF
+    CLS_LEAD_E0, CLS_LEAD_E1_EF, CLS_LEAD_E1_EF, CLS_LEAD_E1_EF,                    // 0xE0 - 0xE3
+    CLS_LEAD_E1_EF, CLS_LEAD_E1_EF, CLS_LEAD_E1_EF, CLS_LEAD_E1_EF,                 // 0xE4 - 0xE7
+    TC_UTF8_CLASS_8(CLS_LEAD_E1_EF),                                                // 0xE8 - 0xEF
+    CLS_LEAD_F0, CLS_LEAD_F1_F7, CLS_LEAD_F1_F7, CLS_LEAD_F1_F7,                    // 0xF0 - 0xF3
+    CLS_LEAD_F1_F7, CLS_LEAD_F1_F7, CLS_LEAD_F1_F7, CLS_LEAD_F1_F7,                 // 0xF4 - 0xF7
+    CLS_INVALID_F8_FD, CLS_INVALID_F8_FD, CLS_INVALID_F8_FD, CLS_INVALID_F8_FD,     // 0xF8 - 0xFB
+    CLS_INVALID_F8_FD, CLS_INVALID_F8_FD, CLS_INVALID_FE_FF, CLS_INVALID_FE_FF      // 0xFC - 0xFF
+#undef TC_UTF8_CLASS_16
+#undef TC_UTF8_CLASS_8
+};
 
-void Utf8TextProcessor::pushChar(char data) {
-    if (encodingMode == ENCMODE_EXT_ASCII) {
-        handler(userData, (uint8_t)data);
-        return;
-    }
+// the bits of each class of byte that belong in the character.
+const uint8_t tccore::utf8table::classPayload[UTF8_BYTE_CLASSES] PROGMEM = {
+    0x00, 0x7F, 0x3F, 0x3F, 0x3F, 0x1F, 0x1F, 0x0F, 0x0F, 0x07, 0x07, 0x00, 0x00
+};
 
-    if((uint8_t)data == 0xFE || (uint8_t)data == 0xFF) {
-        error(0); // should not be passed on ever
-        return;
-    }
+#define TC_UTF8_START(state) (TRN_START | (state))
+#define TC_UTF8_BROKEN(state) (TRN_ERROR_FIRST | TRN_START | (state))
+// the transitions from the accept state, and how a broken sequence continues, are the same apart from the error.
+#define TC_UTF8_FROM_SEQUENCE(cont80, cont90, contA0) \
+    TRN_ERROR_FIRST, TRN_ERROR_FIRST | TRN_EMIT | TRN_START, cont80, cont90, contA0, \
+    TC_UTF8_BROKEN(TST_NEED_1_OVERLONG), TC_UTF8_BROKEN(TST_NEED_1), TC_UTF8_BROKEN(TST_AFTER_E0), \
+    TC_UTF8_BROKEN(TST_NEED_2), TC_UTF8_BROKEN(TST_AFTER_F0), TC_UTF8_BROKEN(TST_NEED_3), \
+    TRN_ERROR_FIRST | TRN_ERROR, TRN_ERROR
 
-    if (decoderState == WAITING_BYTE_0) {
-        processChar0(data);
-    } else if (decoderState == WAITING_BYTE_1) {
-        if ((data & 0xc0) == 0x80) {
-            uint16_t uni = data & 0x3F;
-            if(extraCharsNeeded == 1) {
-                currentUtfChar |= uni;
-                decoderState = UTF_CHAR_FOUND;
-            } else {
-                int shiftAmount = extraCharsNeeded == 3 ? 12 : 6;
-                currentUtfChar |= (uni << shiftAmount);
-                decoderState = WAITING_BYTE_2;
-            }
-        } else {
-            error(data);
-        }
-    } else if (decoderState == WAITING_BYTE_2) {
-        if ((data & 0xc0) == 0x80) {
-            uint16_t uni = data & 0x3F;
-            if(extraCharsNeeded == 2) {
-                decoderState = UTF_CHAR_FOUND;
-                currentUtfChar |= uni;
-            } else {
-                currentUtfChar |= uni << 6;
-                decoderState = WAITING_BYTE_3;
-            }
-        } else {
-            error(data);
-        }
-    } else if (decoderState == WAITING_BYTE_3) {
-        if ((data & 0xc0) == 0x80) {
-            uint32_t uni = data & 0x3F;
-            currentUtfChar |= uni;
-            decoderState = UTF_CHAR_FOUND;
-        } else {
-            error(data);
-        }
-    }
+// as with Utf8TextProcessor::error, a nul that breaks a sequence is not passed on.
+const uint8_t tccore::utf8table::transitions[UTF8_TABLE_STATES][UTF8_BYTE_CLASSES] PROGMEM = {
+    { // TST_ACCEPT
+        TRN_EMIT | TRN_START, TRN_EMIT | TRN_START, TRN_ERROR, TRN_ERROR, TRN_ERROR,
+        TC_UTF8_START(TST_NEED_1_OVERLONG), TC_UTF8_START(TST_NEED_1), TC_UTF8_START(TST_AFTER_E0),
+        TC_UTF8_START(TST_NEED_2), TC_UTF8_START(TST_AFTER_F0), TC_UTF8_START(TST_NEED_3), TRN_ERROR, TRN_ERROR
+    },
+    { TC_UTF8_FROM_SEQUENCE(TRN_EMIT, TRN_EMIT, TRN_EMIT) },                                    // TST_NEED_1
+    { TC_UTF8_FROM_SEQUENCE(TST_NEED_1, TST_NEED_1, TST_NEED_1) },                              // TST_NEED_2
+    { TC_UTF8_FROM_SEQUENCE(TST_NEED_2, TST_NEED_2, TST_NEED_2) },                              // TST_NEED_3
+    { TC_UTF8_FROM_SEQUENCE(TRN_ERROR, TRN_ERROR, TRN_ERROR) },                                 // TST_NEED_1_OVERLONG
+    { TC_UTF8_FROM_SEQUENCE(TST_NEED_1_OVERLONG, TST_NEED_1_OVERLONG, TST_NEED_1_OVERLONG) },   // TST_NEED_2_OVERLONG
+    { TC_UTF8_FROM_SEQUENCE(TST_NEED_1_OVERLONG, TST_NEED_1_OVERLONG, TST_NEED_1) },            // TST_AFTER_E0
+    { TC_UTF8_FROM_SEQUENCE(TST_NEED_2_OVERLONG, TST_NEED_2, TST_NEED_2) }                      // TST_AFTER_F0
+};
+#undef TC_UTF8_FROM_SEQUENCE
+#undef TC_UTF8_BROKEN
+#undef TC_UTF8_START
 
-    // we only go ahead and register the character when a character was found.
-    if (decoderState == UTF_CHAR_FOUND) {
-        decoderState = WAITING_BYTE_0;
-        if(couldSequenceBeSmaller()) {
-            error(0); // completely invalid sequence, ignore
-        } else {
-            handler(userData, currentUtfChar);
-        }
+size_t tccore::utf8AsciiPrefixLength(const char* data, size_t len) {
+    size_t i = 0;
+    while (i < len && ((uintptr_t)(data + i) & (sizeof(size_t) - 1)) != 0) {
+        if (data[i] & 0x80) return i;
+        i++;
     }
-}
 
-void Utf8TextProcessor::processChar0(char data) {
-    if ((data & 0x80) == 0) {
-        currentUtfChar = (uint8_t) data;
-        extraCharsNeeded = 0;
-        decoderState = UTF_CHAR_FOUND;
-    } else if ((data & 0b11100000) == 0b11000000) {
-        currentUtfChar = (uint32_t)(data & 0x1FU) << 6;
-        decoderState = WAITING_BYTE_1;
-        extraCharsNeeded = 1;
-    } else if ((data & 0b11110000) == 0b11100000) {
-        currentUtfChar = (uint32_t)(data & 0x0FU) << 12;
-        decoderState = WAITING_BYTE_1;
-        extraCharsNeeded = 2;
-    } else if ((data & 0b11111000) == 0b11110000) {
-        currentUtfChar = (uint32_t)(data & 0x07U) << 18;
-        decoderState = WAITING_BYTE_1;
-        extraCharsNeeded = 3;
-    } else {
-        error(data);
+    // a word at a time, if any byte in the word has its top bit set the run ends within it.
+    const size_t highBits = (size_t)0x8080808080808080ULL;
+    while (i + sizeof(size_t) <= len) {
+        size_t word;
+        memcpy(&word, data + i, sizeof(size_t));
+        if (word & highBits) break;
+        i += sizeof(size_t);
     }
-}
 
-void Utf8TextProcessor::error(char lastCode) {
-    decoderState = WAITING_BYTE_0;
-    extraCharsNeeded = 0;
-    currentUtfChar = 0;
-    handler(userData, TC_UNICODE_CHAR_ERROR);
-    if(lastCode != 0) {
-        processChar0(lastCode);
-        if(decoderState == UTF_CHAR_FOUND) {
-            decoderState = WAITING_BYTE_0;
-            handler(userData, lastCode);
-        }
-    }
+    while (i < len && (data[i] & 0x80) == 0) i++;
+    return i;
 }
-
-bool Utf8TextProcessor::couldSequenceBeSmaller() const {
-    if(currentUtfChar < 0x80) {
-        return extraCharsNeeded != 0;
-    } else if(currentUtfChar < 0x800 ) {
-        return extraCharsNeeded > 1;
-    } else if(currentUtfChar < 0x10000) {
-        return extraCharsNeeded > 2;
-    }
-
-    return false;
-}
\ No newline at end of file
@@ -9,6 +9,19 @@
 #include <string.h>
 #include <inttypes.h>
 
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+#define TC_UTF8_PGM_READ_BYTE(addr) pgm_read_byte(addr)
+#define TC_UTF8_PGM_READ_WORD(addr) pgm_read_word(addr)
+#elif defined(ESP8266)
+#include <pgmspace.h>
+#define TC_UTF8_PGM_READ_BYTE(addr) pgm_read_byte(addr)
+#define TC_UTF8_PGM_READ_WORD(addr) pgm_read_word(addr)
+#else
+#define TC_UTF8_PGM_READ_BYTE(addr) (*(addr))
+#define TC_UTF8_PGM_READ_WORD(addr) (*(addr))
+#endif
+
 /**
  * @file Utf8TextProcessor.h
  * @brief contains a strict asynchronous UTF-8 decoder that uses very little memory.
@@ -20,9 +33,12 @@
 namespace tccore {
 
     /**
-     * Tells the UTF8 decoder which mode it is in, either extended ASCII or UTF8
+     * Tells the UTF8 decoder which mode it is in, either extended ASCII or UTF8. ENCMODE_UTF8_TABLE decodes UTF8 with
+     * exactly the same rules as ENCMODE_UTF8, but drives the decoder from a small transition table in flash instead of
+     * a chain of conditions. Every byte then takes much the same path, which suits small cores that mispredict on text
+     * mixing ASCII with other scripts, on desktop class processors the two perform about the same.
      */
-    enum UnicodeEncodingMode { ENCMODE_UTF8, ENCMODE_EXT_ASCII };
+    enum UnicodeEncodingMode { ENCMODE_UTF8, ENCMODE_EXT_ASCII, ENCMODE_UTF8_TABLE };
 
     /**
      * This callback will be called for every converted UTF8 or ASCII sequence (depending on the mode of the handler).
@@ -31,34 +47,121 @@ namespace tccore {
     typedef void (*UnicodeCharacterHandler)(void* callbackData, uint32_t convertedChar);
 
     /**
-     * A completely asynchronous implementation of a UTF8 encoder. Can work with the Print interface as it expects no
-     * end to the stream, and requires only a very simple change in the write function.
+     * Finds how many bytes at the start of the data are plain ASCII (below 0x80), checking a machine word at a time once
+     * the data is aligned. This is the fast path for text that is mainly ASCII, as each of these bytes is a complete
+     * character on its own.
+     * @param data the data to check
+     * @param len the number of bytes available
+     * @return the number of ASCII bytes before the first byte with its top bit set, or len if all are ASCII
+     */
+    size_t utf8AsciiPrefixLength(const char* data, size_t len);
+
+    /**
+     * The tables behind the ENCMODE_UTF8_TABLE decoder, each byte is first sorted into a class, and then the class is
+     * looked up in the row for the current state. These are internal to the decoder.
+     */
+    namespace utf8table {
+        enum Utf8ByteClass : uint8_t {
+            CLS_NUL, CLS_ASCII, CLS_CONT_80_8F, CLS_CONT_90_9F, CLS_CONT_A0_BF, CLS_LEAD_C0_C1, CLS_LEAD_C2_DF,
+            CLS_LEAD_E0, CLS_LEAD_E1_EF, CLS_LEAD_F0, CLS_LEAD_F1_F7, CLS_INVALID_F8_FD, CLS_INVALID_FE_FF,
+            UTF8_BYTE_CLASSES
+        };
+
+        // each overlong state means the sequence can only end in an error, just as couldSequenceBeSmaller reports
+        // when the last byte arrives.
+        enum Utf8TableState : uint8_t {
+            TST_ACCEPT, TST_NEED_1, TST_NEED_2, TST_NEED_3, TST_NEED_1_OVERLONG, TST_NEED_2_OVERLONG, TST_AFTER_E0,
+            TST_AFTER_F0, UTF8_TABLE_STATES
+        };
+
+        // the upper bits of each transition say what to do with the byte, the lower bits hold the next state.
+        const uint8_t TRN_STATE_MASK = 0x0F;
+        const uint8_t TRN_ERROR_FIRST = 0x10;   // the current sequence is broken, report that before this byte
+        const uint8_t TRN_EMIT = 0x20;          // this byte completes a character
+        const uint8_t TRN_ERROR = 0x40;         // this byte is an error, or completes an overlong sequence
+        const uint8_t TRN_START = 0x80;         // this byte starts a new character, do not keep the previous bits
+
+        /** the class of each byte */
+        extern const uint8_t byteClasses[256];
+        /** the bits of each class of byte that belong in the character */
+        extern const uint8_t classPayload[UTF8_BYTE_CLASSES];
+        /** the transition for each class of byte in each state */
+        extern const uint8_t transitions[UTF8_TABLE_STATES][UTF8_BYTE_CLASSES];
+
+        /**
+         * Moves the table driven decoder on by one byte, passing on any character or errors that result.
+         * @param state the state, updated to the next state
+         * @param current the character so far, updated with the bits from this byte
+         * @param data the byte to process
+         * @param handler called with each character or error
+         */
+        template<typename Handler> inline void advance(uint8_t& state, uint32_t& current, uint8_t data,
+                                                       Handler& handler) {
+            uint8_t byteClass = TC_UTF8_PGM_READ_BYTE(&byteClasses[data]);
+            uint8_t transition = TC_UTF8_PGM_READ_BYTE(&transitions[state][byteClass]);
+            uint32_t previousBits = (transition & TRN_START) ? 0 : (current << 6);
+            uint32_t nextChar = previousBits | (data & TC_UTF8_PGM_READ_BYTE(&classPayload[byteClass]));
+
+            // the broken sequence is reported before this byte is taken on, a handler that resets the decoder in
+            // response then only clears the broken sequence, not the one this byte starts.
+            if (transition & TRN_ERROR_FIRST) handler(TC_UNICODE_CHAR_ERROR);
+            current = nextChar;
+            state = transition & TRN_STATE_MASK;
+
+            uint8_t action = transition & (TRN_EMIT | TRN_ERROR);
+            if (action == TRN_EMIT) {
+                handler(current);
+            } else if (action != 0) {
+                if (action & TRN_EMIT) handler(current);
+                if (action & TRN_ERROR) handler(TC_UNICODE_CHAR_ERROR);
+            }
+        }
+    }
+
+    /**
+     * The decoder itself, with the handler that receives characters bound at compile time. The handler is any type
+     * that can be called with the character, such as a small struct with an operator() or a lambda, so the compiler
+     * can inline the whole path from each byte to whatever is done with the character. Utf8TextProcessor is this
+     * decoder bound to a function pointer callback.
+     * @tparam Handler the type of the handler, called as `handler(uint32_t ch)` for each character or error
      */
-    class Utf8TextProcessor {
+    template<typename Handler> class BasicUtf8TextProcessor {
     public:
         enum DecoderState {
             WAITING_BYTE_0, WAITING_BYTE_1, WAITING_BYTE_2, WAITING_BYTE_3, UTF_CHAR_FOUND
         };
     private:
         DecoderState decoderState = WAITING_BYTE_0;
+        uint8_t tableState = 0;
         uint32_t currentUtfChar = 0U;
         int extraCharsNeeded = 0;
-        UnicodeCharacterHandler handler;
-        void* userData;
+        Handler handler;
         const UnicodeEncodingMode encodingMode;
+        const uint16_t* codePage = nullptr;
     public:
         /**
          * Create an instance of a UTF-8 decoder that will asynchronous process data calling the handler as characters
          * are decoded from the stream.
-         * @param handler the callback that receives characters
-         * @param userData an optional piece of data to pass back to you in the callback, can be nullptr
-         * @param mode processing mode, either ENCMODE_UTF8 or ENCMODE_EXT_ASCII
+         * @param handler the handler that receives characters, it is copied into the decoder
+         * @param mode processing mode, either ENCMODE_UTF8, ENCMODE_UTF8_TABLE or ENCMODE_EXT_ASCII
          */
-        explicit Utf8TextProcessor(UnicodeCharacterHandler handler, void* userData, UnicodeEncodingMode mode)
-                : handler(handler), userData(userData), encodingMode(mode) {}
+        BasicUtf8TextProcessor(Handler handler, UnicodeEncodingMode mode) : handler(handler), encodingMode(mode) {}
 
         /** completely reset the decoder back to initial state */
-        void reset();
+        void reset() {
+            // clear the text buffer
+            extraCharsNeeded = 0;
+            decoderState = WAITING_BYTE_0;
+            tableState = utf8table::TST_ACCEPT;
+        }
+
+        /**
+         * Sets the code page used in ENCMODE_EXT_ASCII mode to turn bytes 0x80 to 0xFF into unicode characters, for
+         * example `codePageWindows1251` from Utf8CodePages.h. Without a code page, bytes are passed on unchanged, which
+         * is the same as ISO-8859-1. It has no effect in the UTF-8 modes.
+         * @param table a 128 entry table in PROGMEM for bytes 0x80 onwards, or nullptr to pass bytes on unchanged
+         */
+        void setCodePage(const uint16_t* table) { codePage = table; }
 
         /**
          * Pushes a single character through the decoder. As characters are decoded the callback will fire.
@@ -70,9 +173,40 @@ namespace tccore {
          * Pushes a string of character data through the encoder.  As characters are decoded the callback will fire.
          * @param str the string of data to process
          */
-        void pushChars(const char *str);
+        void pushChars(const char *str) {
+            pushChars(str, strlen(str));
+        }
+
+        /**
+         * Pushes a known length of character data through the decoder, it need not be zero terminated, and a sequence
+         * may be split across calls, so this can be given each chunk of data as it arrives. Runs of ASCII are sent
+         * straight to the handler whenever the decoder is between sequences.
+         * @param str the data to process
+         * @param len the number of bytes to process
+         */
+        void pushChars(const char *str, size_t len);
 
     private:
+        /**
+         * @return the character for a byte in ENCMODE_EXT_ASCII mode, looking it up in the code page when there is one
+         */
+        uint32_t extendedAsciiChar(uint8_t data) const {
+            return (data < 0x80 || codePage == nullptr) ? data : TC_UTF8_PGM_READ_WORD(&codePage[data - 0x80]);
+        }
+
+        /**
+         * @return true when the decoder is not part way through a sequence, in whichever mode it is in.
+         */
+        bool isBetweenSequences() const {
+            return encodingMode == ENCMODE_UTF8_TABLE ? tableState == 0 : decoderState == WAITING_BYTE_0;
+        }
+
+        /**
+         * Pushes a single character through the table driven decoder used in ENCMODE_UTF8_TABLE mode.
+         * @param data the character to process
+         */
+        void pushCharTable(uint8_t data);
+
         /**
          * Indicates an error has occurred, somewhat internal to the push.. functions
          * @param lastCode the last character that we received.
@@ -91,6 +225,172 @@ namespace tccore {
         void processChar0(char data);
     };
 
+    template<typename Handler> void BasicUtf8TextProcessor<Handler>::pushChars(const char *str, size_t len) {
+        if (encodingMode == ENCMODE_EXT_ASCII) {
+            for (size_t i = 0; i < len; i++) handler(extendedAsciiChar((uint8_t)str[i]));
+            return;
+        }
+
+        size_t i = 0;
+        while (i < len) {
+            if (isBetweenSequences()) {
+                // between sequences, ASCII is always a character on its own so skip the state machine.
+                size_t asciiEnd = i + utf8AsciiPrefixLength(str + i, len - i);
+                while (i < asciiEnd) handler((uint8_t)str[i++]);
+                if (i == len) break;
+            }
+            pushChar(str[i++]);
+        }
+    }
+
+    template<typename Handler> void BasicUtf8TextProcessor<Handler>::pushChar(char data) {
+        if (encodingMode == ENCMODE_EXT_ASCII) {
+            handler(extendedAsciiChar((uint8_t)data));
+            return;
+        } else if (encodingMode == ENCMODE_UTF8_TABLE) {
+            pushCharTable((uint8_t)data);
+            return;
+        }
+
+        if((uint8_t)data == 0xFE || (uint8_t)data == 0xFF) {
+            error(0); // should not be passed on ever
+            return;
+        }
+
+        if (decoderState == WAITING_BYTE_0) {
+            processChar0(data);
+        } else if (decoderState == WAITING_BYTE_1) {
+            if ((data & 0xc0) == 0x80) {
+                uint16_t uni = data & 0x3F;
+                if(extraCharsNeeded == 1) {
+                    currentUtfChar |= uni;
+                    decoderState = UTF_CHAR_FOUND;
+                } else {
+                    int shiftAmount = extraCharsNeeded == 3 ? 12 : 6;
+                    currentUtfChar |= (uni << shiftAmount);
+                    decoderState = WAITING_BYTE_2;
+                }
+            } else {
+                error(data);
+            }
+        } else if (decoderState == WAITING_BYTE_2) {
+            if ((data & 0xc0) == 0x80) {
+                uint16_t uni = data & 0x3F;
+                if(extraCharsNeeded == 2) {
+                    decoderState = UTF_CHAR_FOUND;
+                    currentUtfChar |= uni;
+                } else {
+                    currentUtfChar |= uni << 6;
+                    decoderState = WAITING_BYTE_3;
+                }
+            } else {
+                error(data);
+            }
+        } else if (decoderState == WAITING_BYTE_3) {
+            if ((data & 0xc0) == 0x80) {
+                uint32_t uni = data & 0x3F;
+                currentUtfChar |= uni;
+                decoderState = UTF_CHAR_FOUND;
+            } else {
+                error(data);
+            }
+        }
+
+        // we only go ahead and register the character when a character was found.
+        if (decoderState == UTF_CHAR_FOUND) {
+            decoderState = WAITING_BYTE_0;
+            if(couldSequenceBeSmaller()) {
+                error(0); // completely invalid sequence, ignore
+            } else {
+                handler(currentUtfChar);
+            }
+        }
+    }
+
+    template<typename Handler> void BasicUtf8TextProcessor<Handler>::processChar0(char data) {
+        if ((data & 0x80) == 0) {
+            currentUtfChar = (uint8_t) data;
+            extraCharsNeeded = 0;
+            decoderState = UTF_CHAR_FOUND;
+        } else if ((data & 0b11100000) == 0b11000000) {
+            currentUtfChar = (uint32_t)(data & 0x1FU) << 6;
+            decoderState = WAITING_BYTE_1;
+            extraCharsNeeded = 1;
+        } else if ((data & 0b11110000) == 0b11100000) {
+            currentUtfChar = (uint32_t)(data & 0x0FU) << 12;
+            decoderState = WAITING_BYTE_1;
+            extraCharsNeeded = 2;
+        } else if ((data & 0b11111000) == 0b11110000) {
+            currentUtfChar = (uint32_t)(data & 0x07U) << 18;
+            decoderState = WAITING_BYTE_1;
+            extraCharsNeeded = 3;
+        } else {
+            // cannot start a sequence, so there's nothing to reprocess, and reprocessing it would never end.
+            error(0);
+        }
+    }
+
+    template<typename Handler> void BasicUtf8TextProcessor<Handler>::error(char lastCode) {
+        decoderState = WAITING_BYTE_0;
+        extraCharsNeeded = 0;
+        currentUtfChar = 0;
+        handler(TC_UNICODE_CHAR_ERROR);
+        if(lastCode != 0) {
+            processChar0(lastCode);
+            if(decoderState == UTF_CHAR_FOUND) {
+                decoderState = WAITING_BYTE_0;
+                handler((uint32_t)lastCode);
+            }
+        }
+    }
+
+    template<typename Handler> bool BasicUtf8TextProcessor<Handler>::couldSequenceBeSmaller() const {
+        if(currentUtfChar < 0x80) {
+            return extraCharsNeeded != 0;
+        } else if(currentUtfChar < 0x800 ) {
+            return extraCharsNeeded > 1;
+        } else if(currentUtfChar < 0x10000) {
+            return extraCharsNeeded > 2;
+        }
+
+        return false;
+    }
+
+    template<typename Handler> void BasicUtf8TextProcessor<Handler>::pushCharTable(uint8_t data) {
+        utf8table::advance(tableState, currentUtfChar, data, handler);
+    }
+
+    /**
+     * Binds a decoder to a function pointer callback and its user data.
+     */
+    struct Utf8CallbackHandler {
+        UnicodeCharacterHandler callback;
+        void* userData;
+
+        void operator()(uint32_t ch) const { callback(userData, ch); }
+    };
+
+    // the callback version is built once in Utf8TextProcessor.cpp rather than in every file that uses it.
+    extern template class BasicUtf8TextProcessor<Utf8CallbackHandler>;
+
+    /**
+     * A completely asynchronous implementation of a UTF8 encoder. Can work with the Print interface as it expects no
+     * end to the stream, and requires only a very simple change in the write function. The handler is a function
+     * pointer, when it is known at compile time use BasicUtf8TextProcessor directly instead.
+     */
+    class Utf8TextProcessor : public BasicUtf8TextProcessor<Utf8CallbackHandler> {
+    public:
+        /**
+         * Create an instance of a UTF-8 decoder that will asynchronous process data calling the handler as characters
+         * are decoded from the stream.
+         * @param handler the callback that receives characters
+         * @param userData an optional piece of data to pass back to you in the callback, can be nullptr
+         * @param mode processing mode, either ENCMODE_UTF8, ENCMODE_UTF8_TABLE or ENCMODE_EXT_ASCII
+         */
+        explicit Utf8TextProcessor(UnicodeCharacterHandler handler, void* userData, UnicodeEncodingMode mode)
+                : BasicUtf8TextProcessor<Utf8CallbackHandler>(Utf8CallbackHandler{handler, userData}, mode) {}
+    };
+
 }
 
 
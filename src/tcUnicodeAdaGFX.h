@@ -16,9 +16,10 @@
 #include <Adafruit_GFX.h>
 
 namespace tcgfx {
-    class AdafruitTextPlotPipeline : public TextPlotPipeline {
+    class AdafruitTextPlotPipeline final : public TextPlotPipeline {
     private:
         Adafruit_GFX *gfx;
+        PixelWindowCursor windowCursor;
     public:
         explicit AdafruitTextPlotPipeline(Adafruit_GFX *gfx) : gfx(gfx) {
         }
@@ -27,6 +28,35 @@ namespace tcgfx {
 
         void drawPixel(uint16_t x, uint16_t y, uint32_t dc) override { return gfx->drawPixel(x, y, dc); }
 
+        void drawHorizontalSpan(uint16_t x, uint16_t y, uint16_t length, uint32_t dc) override {
+            gfx->drawFastHLine(x, y, length, dc);
+        }
+
+        bool drawMonoBitmap(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint8_t* bits, uint32_t dc) override {
+            // the whole glyph is written in one transaction, as runs rather than single pixels
+            gfx->startWrite();
+            forEachGlyphSpan(bits, w, h, [&](uint8_t col, uint8_t row, uint8_t len) {
+                gfx->writeFastHLine(x + col, y + row, len, dc);
+            });
+            gfx->endWrite();
+            return true;
+        }
+
+        bool beginPixelWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t /*h*/) override {
+            // Adafruit_GFX has no address window, so the runs are written as lines within a single transaction
+            gfx->startWrite();
+            windowCursor.begin(x, y, w);
+            return true;
+        }
+
+        void pushPixels(uint32_t dc, uint32_t count) override {
+            windowCursor.push(dc, count, [this](uint16_t x, uint16_t y, uint16_t len, uint32_t c) {
+                gfx->writeFastHLine(x, y, len, c);
+            });
+        }
+
+        void endPixelWindow() override { gfx->endWrite(); }
+
         void setCursor(const Coord &where) override { gfx->setCursor(where.x, where.y); }
 
         Coord getCursor() override { return Coord(gfx->getCursorX(), gfx->getCursorY()); }
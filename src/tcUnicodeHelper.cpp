@@ -5,84 +5,68 @@
 
 #include "tcUnicodeHelper.h"
 
-Coord UnicodeFontHandler::textExtents(const char *text, int *baseline, bool progMem) {
-    if(adaFont == nullptr) {
-        baseline = 0;
-        return Coord(0,0);
-    }
-
-    handlerMode = HANDLER_SIZING_TEXT;
-    xExtentCurrent = 0;
-    utf8.reset();
-    if(progMem) {
-        uint8_t c;
-        while ((c = pgm_read_byte(text++))) utf8.pushChar((char)c);
-    } else {
-        utf8.pushChars(text);
-    }
-    handlerMode = HANDLER_DRAWING_TEXT;
+template class BasicUnicodeFontHandler<TextPlotPipeline>;
 
-    if(baseline) {
-        *baseline = getBaseline();
+Coord UnicodeFontLookup::textExtent(uint32_t theChar) {
+    GlyphWithBitmap gb;
+    if (!findCharInFont(theChar, gb)) {
+        return Coord(0, getYAdvance());
     }
-    return Coord((int)xExtentCurrent, getYAdvance());
+    return Coord(gb.getGlyph()->xAdvance, getYAdvance());
 }
 
-#ifndef internal_max
-#define internal_max(a, b)  ((a) < (b) ? (b) : (a));
-#endif // internal_max
-
-void UnicodeFontHandler::writeUnicode(uint32_t unicodeText) {
-    // make sure it's printable.
-    auto dims = plotter->getDimensions();
-    auto posn = plotter->getCursor();
-    if (posn.x > (int32_t) dims.x) return;
-
-    GlyphWithBitmap gb;
-    if(!findCharInFont(unicodeText, gb)) return;
-    uint8_t w = gb.getGlyph()->width, h = gb.getGlyph()->height;
-    int8_t xo = gb.getGlyph()->xOffset, yo = gb.getGlyph()->yOffset;
-    uint8_t xx, yy, bits = 0, bit = 0;
-
-    uint16_t xDim = dims.x;
-    uint16_t yDim = dims.y;
-    uint16_t x = posn.x;
-    uint16_t y = posn.y;
-
-    const uint8_t* bitmap = gb.getBitmapData();
-    int bo = 0;
-    for (yy = 0; yy < h; yy++) {
-        auto locY = internal_max(0, y + yo + yy);
-        bool yOK = (locY < yDim);
-        for (xx = 0; xx < w; xx++) {
-            if (!(bit++ & 7)) {
-                bits = pgm_read_byte(&bitmap[bo++]);
-            }
-            if (bits & 0x80) {
-                int locX = internal_max(0, int(x +xo + xx));
-                if (locX < xDim && yOK) {
-                    plotter->drawPixel(locX, locY, drawColor);
-                }
-            }
-            bits <<= 1;
-        }
+static int findSortedKey(const uint16_t* keys, size_t count, uint32_t ch) {
+    // the loop always runs log2(count) times, moving the base forward rather than branching on direction.
+    size_t base = 0;
+    while (count > 1) {
+        size_t half = count / 2;
+        if (pgm_read_word(&keys[base + half]) <= ch) base += half;
+        count -= half;
     }
-    plotter->setCursor(Coord(posn.x + gb.getGlyph()->xAdvance, posn.y));
+    return (pgm_read_word(&keys[base]) == ch) ? (int)base : -1;
 }
 
-Coord UnicodeFontHandler::textExtent(uint32_t theChar) {
-    GlyphWithBitmap gb;
-    if (!findCharInFont(theChar, gb)) {
-        return Coord(0, getYAdvance());
+template<typename KeyReader> static int findEytzingerKey(KeyReader keyAt, size_t count, uint32_t ch) {
+    size_t k = 0;
+    while (k < count) {
+        uint32_t key = keyAt(k);
+        if (key == ch) return (int)k;
+        k = (2 * k) + 1 + (key < ch);
     }
-    return Coord(gb.getGlyph()->xAdvance, getYAdvance());
+    return -1;
 }
 
 const UnicodeFontGlyph *findWithinGlyphs(const UnicodeFontBlock* block, uint32_t ch) {
+    auto glyphs = (const UnicodeFontGlyph *)pgm_read_ptr(&block->glyphs);
+    size_t numberOfGlyphs = pgm_read_word(&block->numberOfGlyphs);
+    if (numberOfGlyphs == 0) {
+        // older fonts do not record how many glyphs there are, the number of points is the best we have.
+        numberOfGlyphs = pgm_read_word(&block->numberOfPoints);
+        if (numberOfGlyphs == 0) return nullptr;
+    } else if (pgm_read_byte(&block->blockFlags) & TCFONT_BLOCK_DENSE) {
+        // no gaps in the block, so the glyph index is just the distance from the first glyph.
+        uint32_t idx = ch - pgm_read_word(&glyphs[0].relativeChar);
+        return (idx < numberOfGlyphs) ? &glyphs[idx] : nullptr;
+    } else {
+        // search the packed keys when they are available, so that only the glyph that matches is read.
+        auto keys = (const uint16_t *)pgm_read_ptr(&block->glyphKeys);
+        int idx = -1;
+        if (pgm_read_byte(&block->blockFlags) & TCFONT_BLOCK_EYTZINGER) {
+            if (keys != nullptr) {
+                idx = findEytzingerKey([keys](size_t k) { return pgm_read_word(&keys[k]); }, numberOfGlyphs, ch);
+            } else {
+                idx = findEytzingerKey([glyphs](size_t k) { return pgm_read_word(&glyphs[k].relativeChar); }, numberOfGlyphs, ch);
+            }
+            return (idx < 0) ? nullptr : &glyphs[idx];
+        } else if (keys != nullptr) {
+            idx = findSortedKey(keys, numberOfGlyphs, ch);
+            return (idx < 0) ? nullptr : &glyphs[idx];
+        }
+    }
+
     size_t start = 0;
-    size_t end = pgm_read_word(&block->numberOfPoints) - 1;
+    size_t end = numberOfGlyphs - 1;
     bool failed = false;
-    auto glyphs = (const UnicodeFontGlyph *)pgm_read_ptr(&block->glyphs);
     while (!failed) {
         if(pgm_read_word(&glyphs[start].relativeChar) == ch) return &glyphs[start];
         if(pgm_read_word(&glyphs[end].relativeChar) == ch) return &glyphs[end];
@@ -100,88 +84,115 @@ const UnicodeFontGlyph *findWithinGlyphs(const UnicodeFontBlock* block, uint32_t
     return nullptr;
 }
 
-UnicodeFontGlyph globalGlyphForFindChar;
+static const UnicodeFontBlock* findBlockForCode(const UnicodeFontBlock* blocks, uint16_t numBlocks, uint32_t code);
 
 inline void copyFontGlyphFromProgmem(UnicodeFontGlyph* dest, const UnicodeFontGlyph* src) {
     memcpy_P(dest, src, sizeof(UnicodeFontGlyph));
 }
 
-bool UnicodeFontHandler::findCharInFont(uint32_t code, GlyphWithBitmap& glyphBitmap) const {
+bool UnicodeFontLookup::findCharInFont(uint32_t code, GlyphWithBitmap& glyphBitmap) const {
     if(adaFont == nullptr) return false; // no font, then no characters!
+    if(glyphCache == nullptr) return glyphLookup(adaFont, code, glyphBitmap);
 
-    if (fontAdafruit) {
-        auto firstCode = pgm_read_word(&adaFont->first);
-        if (code < firstCode || code > pgm_read_word(&adaFont->last)) return false;
-        uint32_t idx = code - firstCode;
-        auto glyphs = (const GFXglyph*)pgm_read_ptr(&adaFont->glyph);
-        globalGlyphForFindChar.relativeChar = code;
-        globalGlyphForFindChar.height = pgm_read_byte(&glyphs[idx].height);
-        globalGlyphForFindChar.width = pgm_read_byte(&glyphs[idx].width);
-        globalGlyphForFindChar.xAdvance = pgm_read_byte(&glyphs[idx].xAdvance);
-        globalGlyphForFindChar.xOffset = (int8_t)pgm_read_byte(&glyphs[idx].xOffset);
-        globalGlyphForFindChar.yOffset = (int8_t)pgm_read_byte(&glyphs[idx].yOffset);
-        globalGlyphForFindChar.relativeBmpOffset = pgm_read_word(&glyphs[idx].bitmapOffset); // unused
-        glyphBitmap.setGlyph(&globalGlyphForFindChar);
-        uint8_t* bitmapPtr = ((uint8_t*)pgm_read_ptr(&adaFont->bitmap)) + globalGlyphForFindChar.relativeBmpOffset;
-        glyphBitmap.setBitmapData(bitmapPtr);
-        return true;
-    } else {
-        uint16_t numBlocks = pgm_read_word(&unicodeFont->numberOfBlocks);
-        auto blocks = (const UnicodeFontBlock*) pgm_read_ptr(&unicodeFont->unicodeBlocks);
-        for (uint16_t i = 0; i < numBlocks; i++) {
-            uint32_t startingNum = pgm_read_dword(&blocks[i].startingNum);
-            uint32_t endingNum = startingNum + pgm_read_word(&blocks[i].numberOfPoints);
-            if (code >= startingNum && code <= endingNum) {
-                const UnicodeFontGlyph *glyph = findWithinGlyphs(&blocks[i], code - startingNum);
-                if (glyph != nullptr) {
-                    copyFontGlyphFromProgmem(&globalGlyphForFindChar, glyph);
-                    glyphBitmap.setGlyph(&globalGlyphForFindChar);
-                    glyphBitmap.setBitmapData(((uint8_t*)pgm_read_ptr(&blocks[i].bitmap)) + globalGlyphForFindChar.relativeBmpOffset);
-                    return true;
-                }
-            }
-        }
-    }
+    if(glyphCache->findGlyph(adaFont, code, glyphBitmap)) return true;
+    if(!glyphLookup(adaFont, code, glyphBitmap)) return false;
+    glyphCache->storeGlyph(adaFont, code, glyphBitmap);
+    return true;
+}
 
-    return false;
+bool GlyphLookup<AdafruitFontLayout>::findGlyph(const void* font, uint32_t code, GlyphWithBitmap& glyphBitmap) {
+    auto adaFont = (const GFXfont*)font;
+    auto firstCode = pgm_read_word(&adaFont->first);
+    if (code < firstCode || code > pgm_read_word(&adaFont->last)) return false;
+    auto glyphs = (const GFXglyph*)pgm_read_ptr(&adaFont->glyph);
+
+    // the glyph is always built in the caller's storage, so that lookups are reentrant.
+    GFXglyph adaGlyph;
+    memcpy_P(&adaGlyph, &glyphs[code - firstCode], sizeof(GFXglyph));
+    UnicodeFontGlyph& glyphStorage = glyphBitmap.glyph;
+    glyphStorage.relativeChar = code;
+    glyphStorage.relativeBmpOffset = adaGlyph.bitmapOffset;
+    glyphStorage.width = adaGlyph.width;
+    glyphStorage.height = adaGlyph.height;
+    glyphStorage.xAdvance = adaGlyph.xAdvance;
+    glyphStorage.xOffset = adaGlyph.xOffset;
+    glyphStorage.yOffset = adaGlyph.yOffset;
+    glyphBitmap.glyphPresent = true;
+    glyphBitmap.setBitmapData(((const uint8_t*)pgm_read_ptr(&adaFont->bitmap)) + adaGlyph.bitmapOffset);
+    return true;
 }
 
-void UnicodeFontHandler::internalHandleUnicodeFont(uint32_t ch) {
-    if (ch == TC_UNICODE_CHAR_ERROR) {
-        utf8.reset();
-        return;
-    }
+static bool findGlyphInBlock(const UnicodeFontBlock *block, uint32_t code, UnicodeFontGlyph& glyphOut, const uint8_t*& bitmapOut) {
+    uint32_t startingNum = pgm_read_dword(&block->startingNum);
+    uint32_t endingNum = startingNum + pgm_read_word(&block->numberOfPoints);
+    if (code < startingNum || code > endingNum) return false;
+
+    const UnicodeFontGlyph *glyph = findWithinGlyphs(block, code - startingNum);
+    if (glyph == nullptr) return false;
+    copyFontGlyphFromProgmem(&glyphOut, glyph);
+    bitmapOut = ((const uint8_t*)pgm_read_ptr(&block->bitmap)) + glyphOut.relativeBmpOffset;
+    return true;
+}
 
-    switch(handlerMode) {
-        case HANDLER_SIZING_TEXT:
-            xExtentCurrent += textExtent(ch).x;
-            break;
-        case HANDLER_DRAWING_TEXT:
-            writeUnicode(ch);
-            break;
+bool GlyphLookup<TcUnicodeFontLayout>::findGlyph(const void* font, uint32_t code, GlyphWithBitmap& glyphBitmap) {
+    auto unicodeFont = (const UnicodeFont*)font;
+    uint16_t numBlocks = pgm_read_word(&unicodeFont->numberOfBlocks);
+    auto blocks = (const UnicodeFontBlock*) pgm_read_ptr(&unicodeFont->unicodeBlocks);
+
+    // the glyph is always built in the caller's storage, so that lookups are reentrant.
+    if (numBlocks > TC_UNICODE_LINEAR_BLOCK_SEARCH_MAX) {
+        auto block = findBlockForCode(blocks, numBlocks, code);
+        if (block == nullptr || !findGlyphInBlock(block, code, glyphBitmap.glyph, glyphBitmap.bitmapData)) return false;
+    } else {
+        uint16_t i = 0;
+        while (i < numBlocks && !findGlyphInBlock(&blocks[i], code, glyphBitmap.glyph, glyphBitmap.bitmapData)) i++;
+        if (i == numBlocks) return false;
     }
+    glyphBitmap.glyphPresent = true;
+    return true;
 }
 
-size_t UnicodeFontHandler::write(uint8_t data) {
-    if(adaFont == nullptr) return 0;
+static void fillEytzinger(const UnicodeFontGlyph* sortedGlyphs, uint16_t count, size_t k, uint16_t& nextSorted,
+                          UnicodeFontGlyph* glyphsOut, uint16_t* keysOut) {
+    if (k >= count) return;
+    fillEytzinger(sortedGlyphs, count, (2 * k) + 1, nextSorted, glyphsOut, keysOut);
+    glyphsOut[k] = sortedGlyphs[nextSorted++];
+    if (keysOut != nullptr) keysOut[k] = glyphsOut[k].relativeChar;
+    fillEytzinger(sortedGlyphs, count, (2 * k) + 2, nextSorted, glyphsOut, keysOut);
+}
 
-    handlerMode = HANDLER_DRAWING_TEXT;
-    utf8.pushChar((char)data);
-    return 1;
+void tcUnicodeEytzingerLayout(const UnicodeFontGlyph* sortedGlyphs, uint16_t count, UnicodeFontGlyph* glyphsOut,
+                              uint16_t* keysOut) {
+    uint16_t nextSorted = 0;
+    fillEytzinger(sortedGlyphs, count, 0, nextSorted, glyphsOut, keysOut);
 }
 
-size_t UnicodeFontHandler::print_P(const char *textPgm) {
-    if(adaFont == nullptr) return 0;
-    uint8_t c;
-    size_t count= 0;
-    while ((c = pgm_read_byte(textPgm++))) {
-        utf8.pushChar((char)c);
-        count++;
+void tcUnicodeBuildGlyphKeys(const UnicodeFontGlyph* glyphs, uint16_t count, uint16_t* keysOut) {
+    for (uint16_t i = 0; i < count; i++) {
+        keysOut[i] = glyphs[i].relativeChar;
+    }
+}
+
+static const UnicodeFontBlock* findBlockForCode(const UnicodeFontBlock* blocks, uint16_t numBlocks, uint32_t code) {
+    // blocks are generated in reverse order of starting code, but also allow for fonts in ascending order.
+    bool descending = pgm_read_dword(&blocks[0].startingNum) > pgm_read_dword(&blocks[numBlocks - 1].startingNum);
+
+    // find the block with the highest starting code that is not above the code we want.
+    size_t lo = 0, hi = numBlocks;
+    while (lo < hi) {
+        size_t mid = lo + ((hi - lo) / 2);
+        bool startNotAbove = pgm_read_dword(&blocks[mid].startingNum) <= code;
+        if (startNotAbove == descending) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
     }
-    return count;
+    if (descending) return (lo < numBlocks) ? &blocks[lo] : nullptr;
+    return (lo > 0) ? &blocks[lo - 1] : nullptr;
 }
 
-int UnicodeFontHandler::getBaseline() {
+int UnicodeFontLookup::getBaseline() {
     if(adaFont == nullptr) return 0;
     if(calculatedBaseline == -1) {
         auto current = "|jy";
@@ -9,7 +9,17 @@
 #include <string.h>
 #include <inttypes.h>
 #include "Utf8TextProcessor.h"
+#include "Utf8CodePages.h"
+#include "Utf8Literal.h"
 #include "UnicodeFontDefs.h"
+#include "UnicodeGlyphCache.h"
+#include "GlyphSpanCache.h"
+
+#if __has_include (<Print.h>) || defined(ARDUINO_SAM_DUE)
+#include <Print.h>
+#elif __has_include(<PrintCompat.h>)
+#include <PrintCompat.h>
+#endif
 
 #define TCUNICODE_API_VERSION 2
 
@@ -65,6 +75,132 @@ namespace tcgfx {
 
 using namespace tcgfx;
 
+/**
+ * @param bits a value that is not zero
+ * @return the number of zero bits above the highest set bit
+ */
+inline uint8_t glyphLeadingZeros(uint32_t bits) {
+#if defined(__GNUC__) && __SIZEOF_INT__ >= 4
+    return (uint8_t)__builtin_clz(bits);
+#elif defined(__GNUC__)
+    return (uint8_t)__builtin_clzl(bits);
+#else
+    uint8_t count = 0;
+    while (!(bits & 0x80000000UL)) {
+        bits <<= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+/**
+ * Reads the bits of a glyph bitmap in order, most significant bit first, through a 32 bit window so that runs of
+ * clear or set bits can be measured with a count of leading zeros instead of one bit at a time. Where the bitmap is
+ * aligned the window is filled with a single pgm_read_dword, otherwise a byte at a time, it never reads past the
+ * last byte that holds a wanted bit.
+ */
+class GlyphBitReader {
+private:
+    const uint8_t* bitmap;
+    uint32_t window = 0;
+    uint16_t nextByte;
+    uint16_t endByte;
+    uint8_t available = 0;
+
+    void refill() {
+        if (((uintptr_t)(bitmap + nextByte) & 3) == 0 && (uint32_t)nextByte + 4 <= endByte) {
+            window = pgm_read_dword(bitmap + nextByte);
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            window = (window >> 24) | ((window >> 8) & 0xFF00UL) | ((window << 8) & 0xFF0000UL) | (window << 24);
+#endif
+            nextByte += 4;
+            available = 32;
+        } else {
+            window = (uint32_t)pgm_read_byte(bitmap + nextByte) << 24;
+            nextByte++;
+            available = 8;
+        }
+    }
+
+    void consume(uint8_t count) {
+        window = (count < 32) ? window << count : 0;
+        available -= count;
+    }
+
+    uint8_t takeRun(uint8_t maxLength, bool setBits) {
+        uint8_t taken = 0;
+        while (taken < maxLength) {
+            if (available == 0) refill();
+            uint32_t run = setBits ? ~window : window;
+            uint8_t length = run ? glyphLeadingZeros(run) : 32;
+            if (length > available) length = available;
+            if (length > maxLength - taken) length = maxLength - taken;
+            consume(length);
+            taken += length;
+            if (available != 0) break; // the run ended inside the window
+        }
+        return taken;
+    }
+public:
+    /**
+     * @param bitmap the glyph bitmap, usually in program memory
+     * @param startBit the bit to start reading from
+     * @param endBit one past the last bit that will be read
+     */
+    GlyphBitReader(const uint8_t* bitmap, uint32_t startBit, uint32_t endBit)
+            : bitmap(bitmap), nextByte(startBit >> 3), endByte((endBit + 7) >> 3) {
+        if (startBit & 7) {
+            refill();
+            consume(startBit & 7);
+        }
+    }
+
+    /** @return the number of clear bits skipped, stopping at the next set bit or after maxLength bits */
+    uint8_t skipClear(uint8_t maxLength) { return takeRun(maxLength, false); }
+    /** @return the number of set bits taken, stopping at the next clear bit or after maxLength bits */
+    uint8_t takeSet(uint8_t maxLength) { return takeRun(maxLength, true); }
+};
+
+/**
+ * Decodes a 1bpp glyph bitmap into horizontal runs of set bits, calling the span function once for each run. The bitmap
+ * is packed most significant bit first, and rows follow directly on from each other without any padding, this is how
+ * both Adafruit and TcUnicode fonts store their glyphs. The bitmap is read using GlyphBitReader so it can be in program
+ * memory, runs of clear bits are skipped in one step rather than a bit at a time. This is used by the font handler and
+ * by any plot pipeline that natively supports glyph drawing. Only the rows from firstRow up to but excluding endRow are
+ * decoded, the bitmap position is moved directly to the first row.
+ * @param bitmap the glyph bitmap data, with the offset for the glyph already applied
+ * @param w the width of the glyph in pixels
+ * @param firstRow the first row to decode
+ * @param endRow one past the last row to decode, at most the height of the glyph
+ * @param spanFn called as spanFn(uint8_t col, uint8_t row, uint8_t length) for each run, relative to the glyph origin
+ */
+template<typename SpanFunction> void forEachGlyphSpan(const uint8_t* bitmap, uint8_t w, uint8_t firstRow, uint8_t endRow,
+                                                      SpanFunction spanFn) {
+    if (w == 0 || firstRow >= endRow) return;
+    GlyphBitReader reader(bitmap, (uint32_t)firstRow * w, (uint32_t)endRow * w);
+    for (uint8_t yy = firstRow; yy < endRow; yy++) {
+        uint8_t xx = reader.skipClear(w);
+        while (xx < w) {
+            uint8_t length = reader.takeSet(w - xx);
+            spanFn(xx, yy, length);
+            xx += length;
+            xx += reader.skipClear(w - xx);
+        }
+    }
+}
+
+/**
+ * Decodes every row of a 1bpp glyph bitmap into horizontal runs of set bits, see the above version for details.
+ * @param bitmap the glyph bitmap data, with the offset for the glyph already applied
+ * @param w the width of the glyph in pixels
+ * @param h the height of the glyph in pixels
+ * @param spanFn called as spanFn(uint8_t col, uint8_t row, uint8_t length) for each run, relative to the glyph origin
+ */
+template<typename SpanFunction> void forEachGlyphSpan(const uint8_t* bitmap, uint8_t w, uint8_t h, SpanFunction spanFn) {
+    forEachGlyphSpan(bitmap, w, 0, h, spanFn);
+}
+
 /**
  * A plot pipeline takes care of actually drawing the font glyphs in terms of pixels and cursor positions, it allows
  * for independent implementation on many different graphics libraries. There are ready made implementation for U8G2,
@@ -81,6 +217,65 @@ public:
      * @param color the color in whatever format the device uses
      */
     virtual void drawPixel(uint16_t x, uint16_t y, uint32_t color) = 0;
+    /**
+     * Draw a horizontal run of pixels starting at the given coordinates and moving right. The font handler coalesces
+     * consecutive set bits of each glyph row into a single span, so implementations that map this onto the library's
+     * fast horizontal line function avoid a call (and on SPI displays an address window) per pixel. The default
+     * implementation simply calls drawPixel for each pixel in the span.
+     * @param x the x position of the leftmost pixel
+     * @param y the y position of the span
+     * @param length the number of pixels in the span, always at least one
+     * @param color the color in whatever format the device uses
+     */
+    virtual void drawHorizontalSpan(uint16_t x, uint16_t y, uint16_t length, uint32_t color) {
+        for (uint16_t i = 0; i < length; i++) {
+            drawPixel(x + i, y, color);
+        }
+    }
+    /**
+     * Optionally draw a complete 1bpp glyph mask in a single call, pipelines that can hand the glyph over to native
+     * library code should override this and return true. The bitmap is in the same packed format described in
+     * `forEachGlyphSpan`, which can be used to decode it, and is usually in program memory. Only set bits are drawn in
+     * the foreground color. The font handler only calls this when the glyph is entirely on the display. The default
+     * implementation returns false, in which case the handler decodes the bitmap itself and draws spans.
+     * @param x the x position of the top left of the glyph
+     * @param y the y position of the top left of the glyph
+     * @param w the width of the glyph in pixels
+     * @param h the height of the glyph in pixels
+     * @param bits the packed glyph bitmap
+     * @param fg the color in whatever format the device uses
+     * @return true if the glyph was drawn, otherwise false.
+     */
+    virtual bool drawMonoBitmap(uint16_t /*x*/, uint16_t /*y*/, uint16_t /*w*/, uint16_t /*h*/, const uint8_t* /*bits*/,
+                                uint32_t /*fg*/) {
+        return false;
+    }
+    /**
+     * Optionally open a window on the display that pixels are then streamed into using `pushPixels`, left to right and
+     * top to bottom, opaque text uses this to paint a whole character cell in one pass. Pipelines for displays with an
+     * address window should override this along with `pushPixels` and `endPixelWindow` and return true. The window is
+     * always entirely on the display. The default implementation returns false, in which case the handler draws the
+     * cell as spans of foreground and background instead.
+     * @param x the x position of the top left of the window
+     * @param y the y position of the top left of the window
+     * @param w the width of the window
+     * @param h the height of the window
+     * @return true if the window is open and pixels can be pushed, otherwise false.
+     */
+    virtual bool beginPixelWindow(uint16_t /*x*/, uint16_t /*y*/, uint16_t /*w*/, uint16_t /*h*/) {
+        return false;
+    }
+    /**
+     * Push a run of pixels of one color into the window opened by `beginPixelWindow`, a run can continue from the end
+     * of one row onto the next.
+     * @param color the color in whatever format the device uses
+     * @param count the number of pixels in the run
+     */
+    virtual void pushPixels(uint32_t /*color*/, uint32_t /*count*/) { }
+    /**
+     * Close the window opened by `beginPixelWindow`, by this time exactly enough pixels to fill it have been pushed.
+     */
+    virtual void endPixelWindow() { }
     /**
      * Set the position that the next text will be printed at, handling of offscreen is minimal, and just stops rendering
      * @param where the coordinate to draw at
@@ -96,16 +291,67 @@ public:
     virtual Coord getDimensions() = 0;
 };
 
+/**
+ * Keeps track of the position within a pixel window, for pipelines whose library has no address window of its own, so
+ * that the pixels pushed into the window can be drawn as horizontal spans, a run that continues onto the next row is
+ * split at the end of the row.
+ */
+class PixelWindowCursor {
+private:
+    uint16_t left = 0;
+    uint16_t top = 0;
+    uint16_t width = 1;
+    uint16_t col = 0;
+    uint16_t row = 0;
+public:
+    void begin(uint16_t x, uint16_t y, uint16_t w) {
+        left = x;
+        top = y;
+        width = w;
+        col = row = 0;
+    }
+
+    /**
+     * @param color the color of the run
+     * @param count the number of pixels in the run
+     * @param spanFn called as spanFn(uint16_t x, uint16_t y, uint16_t length, uint32_t color) for each part of the run
+     */
+    template<typename SpanFunction> void push(uint32_t color, uint32_t count, SpanFunction spanFn) {
+        while (count > 0) {
+            uint16_t length = (count < (uint32_t)(width - col)) ? (uint16_t)count : (uint16_t)(width - col);
+            spanFn(left + col, top + row, length, color);
+            count -= length;
+            col += length;
+            if (col == width) {
+                col = 0;
+                row++;
+            }
+        }
+    }
+};
+
 #define TC_UNICODE_CHAR_ERROR 0xffffffff
 
+/**
+ * Fonts with more blocks than this have their blocks found by binary search on the starting code, which requires the
+ * blocks to be sorted, as the designer generates them. Smaller fonts are scanned in order.
+ */
+#ifndef TC_UNICODE_LINEAR_BLOCK_SEARCH_MAX
+#define TC_UNICODE_LINEAR_BLOCK_SEARCH_MAX 8
+#endif
+
 /**
  * Represents an item that can be drawn using the TcMenu font drawing functions. Regardless of if it is Adafruit
- * or TcUnicode we wrap it in one of these so the drawing code is always the same.
+ * or TcUnicode we wrap it in one of these so the drawing code is always the same. The glyph is copied into storage
+ * owned by this object during lookup, so each caller has its own copy and lookups on different threads or cores do
+ * not interfere with each other.
  */
 class GlyphWithBitmap {
 private:
     const uint8_t *bitmapData = nullptr;
-    const UnicodeFontGlyph *glyph = nullptr;
+    UnicodeFontGlyph glyph = {};
+    bool glyphPresent = false;
+    template<typename FontLayout> friend struct GlyphLookup;
 public:
     /**
      * @return the actual bitmap data with offset already applied
@@ -115,112 +361,422 @@ public:
     }
 
     /**
-     * @return the glyph instructions for rendering. This structure is always in RAM and not progmem.
+     * @return the glyph instructions for rendering. This structure is always in RAM and not progmem, it is owned by
+     * this object and remains valid for as long as it does.
      */
     const UnicodeFontGlyph *getGlyph() const {
-        return glyph;
+        return glyphPresent ? &glyph : nullptr;
     }
 
     void setBitmapData(const uint8_t *bm) {
         GlyphWithBitmap::bitmapData = bm;
     }
 
+    /**
+     * Copies the glyph provided into this object's own storage
+     * @param g the glyph to copy, it must be in RAM
+     */
     void setGlyph(const UnicodeFontGlyph *g) {
-        GlyphWithBitmap::glyph = g;
+        glyphPresent = g != nullptr;
+        if (glyphPresent) glyph = *g;
+    }
+};
+
+/**
+ * Tag types that select how glyphs are found in a font. Adafruit fonts have a glyph for every character from first to
+ * last, whereas TcUnicode fonts are split into blocks that each have to be searched.
+ */
+struct AdafruitFontLayout {};
+struct TcUnicodeFontLayout {};
+
+/**
+ * Finds glyphs in one layout of font, there is a specialization for each layout. The font handler picks the lookup
+ * once when the font is set, so there is no check of the font type for each glyph.
+ */
+template<typename FontLayout> struct GlyphLookup;
+
+template<> struct GlyphLookup<AdafruitFontLayout> {
+    /**
+     * Find a character in an Adafruit font, the glyph record is copied out of program memory in one go.
+     * @param font the GFXfont to search
+     * @param code the character to find
+     * @param glyphBitmap filled in with the glyph and bitmap when found
+     * @return true if found, otherwise false.
+     */
+    static bool findGlyph(const void* font, uint32_t code, GlyphWithBitmap& glyphBitmap);
+};
+
+template<> struct GlyphLookup<TcUnicodeFontLayout> {
+    /**
+     * Find a character in a TcUnicode font, searching only the block that could contain it.
+     * @param font the UnicodeFont to search
+     * @param code the character to find
+     * @param glyphBitmap filled in with the glyph and bitmap when found
+     * @return true if found, otherwise false.
+     */
+    static bool findGlyph(const void* font, uint32_t code, GlyphWithBitmap& glyphBitmap);
+};
+
+/**
+ * Where a glyph is to be drawn on the display, along with the part of it that is visible. The visible rows and
+ * columns are relative to the glyph origin, and there is always at least one of each.
+ */
+struct GlyphPlacement {
+    const uint8_t* bitmap;
+    int16_t left;
+    int16_t top;
+    uint8_t width;
+    uint8_t height;
+    uint8_t firstCol;
+    uint8_t endCol;
+    uint8_t firstRow;
+    uint8_t endRow;
+
+    bool isFullyVisible() const {
+        return firstCol == 0 && firstRow == 0 && endCol == width && endRow == height;
     }
 };
 
+/**
+ * Makes the calls from a font handler into its pipeline. A concrete pipeline type that derives from TextPlotPipeline
+ * must be declared final, the compiler then knows no other override can be called, so the calls bind at compile time
+ * and can be inlined. This is checked when the handler is compiled. Pipelines without virtual functions need nothing
+ * more. For TextPlotPipeline itself the calls remain virtual.
+ */
+template<typename Pipeline> struct PipelineCalls {
+    // compiler builtins rather than std::is_final, as not every Arduino toolchain has <type_traits>.
+    static_assert(!__is_polymorphic(Pipeline) || __is_final(Pipeline),
+                  "a pipeline with virtual functions must be declared final to be bound to a font handler");
+
+    static void drawHorizontalSpan(Pipeline* p, uint16_t x, uint16_t y, uint16_t length, uint32_t color) {
+        p->drawHorizontalSpan(x, y, length, color);
+    }
+    static bool drawMonoBitmap(Pipeline* p, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint8_t* bits, uint32_t fg) {
+        return p->drawMonoBitmap(x, y, w, h, bits, fg);
+    }
+    static bool beginPixelWindow(Pipeline* p, uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+        return p->beginPixelWindow(x, y, w, h);
+    }
+    static void pushPixels(Pipeline* p, uint32_t color, uint32_t count) { p->pushPixels(color, count); }
+    static void endPixelWindow(Pipeline* p) { p->endPixelWindow(); }
+    static void setCursor(Pipeline* p, const Coord& where) { p->setCursor(where); }
+    static Coord getCursor(Pipeline* p) { return p->getCursor(); }
+    static Coord getDimensions(Pipeline* p) { return p->getDimensions(); }
+};
+
+template<> struct PipelineCalls<TextPlotPipeline> {
+    static void drawHorizontalSpan(TextPlotPipeline* p, uint16_t x, uint16_t y, uint16_t length, uint32_t color) {
+        p->drawHorizontalSpan(x, y, length, color);
+    }
+    static bool drawMonoBitmap(TextPlotPipeline* p, uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint8_t* bits,
+                               uint32_t fg) {
+        return p->drawMonoBitmap(x, y, w, h, bits, fg);
+    }
+    static bool beginPixelWindow(TextPlotPipeline* p, uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+        return p->beginPixelWindow(x, y, w, h);
+    }
+    static void pushPixels(TextPlotPipeline* p, uint32_t color, uint32_t count) { p->pushPixels(color, count); }
+    static void endPixelWindow(TextPlotPipeline* p) { p->endPixelWindow(); }
+    static void setCursor(TextPlotPipeline* p, const Coord& where) { p->setCursor(where); }
+    static Coord getCursor(TextPlotPipeline* p) { return p->getCursor(); }
+    static Coord getDimensions(TextPlotPipeline* p) { return p->getDimensions(); }
+};
+
+/**
+ * Draws glyph bitmaps of a given format, there is a specialization for each BitmapFormat. Adafruit fonts pack their
+ * bitmaps in the same way as TcUnicode one bit per pixel fonts, so they share that rasterizer. Each is a template on
+ * the pipeline so that a handler bound to a concrete pipeline can have the drawing calls inlined.
+ */
+template<BitmapFormat format> struct GlyphRasterizer;
+
+template<> struct GlyphRasterizer<TCFONT_ONE_BIT_PER_PIXEL> {
+    /**
+     * Draw the visible part of a glyph, the whole glyph is offered to the pipeline as a bitmap when none of it is
+     * clipped, otherwise it is drawn as spans.
+     * @param plotter the pipeline to draw onto
+     * @param placement the glyph position and visible area
+     * @param color the color to draw the set bits in
+     */
+    template<typename Pipeline> static void drawGlyph(Pipeline* plotter, const GlyphPlacement& placement, uint32_t color) {
+        if (placement.isFullyVisible() && PipelineCalls<Pipeline>::drawMonoBitmap(plotter, placement.left, placement.top,
+                                                                                  placement.width, placement.height,
+                                                                                  placement.bitmap, color)) {
+            return;
+        }
+        forEachGlyphSpan(placement.bitmap, placement.width, placement.firstRow, placement.endRow,
+                         [plotter, &placement, color](uint8_t col, uint8_t row, uint8_t len) {
+            int start = (col < placement.firstCol) ? placement.firstCol : col;
+            int end = (col + len > placement.endCol) ? placement.endCol : col + len;
+            if (start < end) {
+                PipelineCalls<Pipeline>::drawHorizontalSpan(plotter, placement.left + start, placement.top + row,
+                                                            end - start, color);
+            }
+        });
+    }
+};
+
+/** The signature of GlyphLookup::findGlyph, so that the lookup for a font can be chosen at runtime */
+typedef bool (*GlyphLookupFunction)(const void* font, uint32_t code, GlyphWithBitmap& glyphBitmap);
+
+/**
+ * @param format the bitmap format of a font
+ * @return the rasterizer for the format drawing onto the given type of pipeline, or nullptr if the format is not
+ * supported, in which case nothing is drawn.
+ */
+template<typename Pipeline> void (*glyphRasterizerFor(BitmapFormat format))(Pipeline*, const GlyphPlacement&, uint32_t) {
+    switch (format) {
+        case TCFONT_ONE_BIT_PER_PIXEL:
+            return &GlyphRasterizer<TCFONT_ONE_BIT_PER_PIXEL>::template drawGlyph<Pipeline>;
+        default:
+            return nullptr;
+    }
+}
+
+/**
+ * Callback that passes characters from a Utf8TextProcessor to the UnicodeFontHandler given as the user data, the handler
+ * itself binds its decoder at compile time, so this remains for compatibility.
+ */
 void handleUtf8Drawing(void *userData, uint32_t ch);
 
+/**
+ * For font generators and host side tools, builds the packed key array for a block whose glyphs are in sorted order,
+ * this is then referenced by `glyphKeys` in the block so that searches only read the keys.
+ * @param glyphs the glyphs of the block in sorted order, in RAM
+ * @param count the number of glyphs
+ * @param keysOut an array of count entries to receive the keys
+ */
+void tcUnicodeBuildGlyphKeys(const UnicodeFontGlyph* glyphs, uint16_t count, uint16_t* keysOut);
+
+/**
+ * For font generators and host side tools, reorders the glyphs of a block into Eytzinger (breadth first) order, and
+ * optionally builds the matching key array. The block should then be marked with `TCFONT_BLOCK_EYTZINGER`.
+ * @param sortedGlyphs the glyphs of the block in sorted order, in RAM
+ * @param count the number of glyphs
+ * @param glyphsOut an array of count entries to receive the reordered glyphs
+ * @param keysOut an array of count entries to receive the keys in the same order, or nullptr if not needed
+ */
+void tcUnicodeEytzingerLayout(const UnicodeFontGlyph* sortedGlyphs, uint16_t count, UnicodeFontGlyph* glyphsOut,
+                              uint16_t* keysOut);
+
+/**
+ * Holds the current font of a font handler and finds glyphs within it. None of this depends on the pipeline, so it is
+ * shared by every BasicUnicodeFontHandler rather than being compiled again for each pipeline type.
+ */
+class UnicodeFontLookup {
+protected:
+    UnicodeGlyphCache *glyphCache = nullptr;
+    union {
+        const UnicodeFont *unicodeFont;
+        const GFXfont *adaFont;
+    };
+    GlyphLookupFunction glyphLookup = nullptr;
+    bool fontAdafruit = false;
+    int16_t calculatedBaseline = -1;
+
+    void selectFont(const UnicodeFont *font) {
+        unicodeFont = font;
+        fontAdafruit = false;
+        calculatedBaseline = -1;
+        glyphLookup = &GlyphLookup<TcUnicodeFontLayout>::findGlyph;
+    }
+
+    void selectFont(const GFXfont *font) {
+        adaFont = font;
+        fontAdafruit = true;
+        calculatedBaseline = -1;
+        glyphLookup = &GlyphLookup<AdafruitFontLayout>::findGlyph;
+    }
+
+    /**
+     * @return the bitmap format of the current font, Adafruit fonts are always one bit per pixel.
+     */
+    BitmapFormat currentBitmapFormat() const {
+        if (fontAdafruit || unicodeFont == nullptr) return TCFONT_ONE_BIT_PER_PIXEL;
+        return (BitmapFormat)pgm_read_byte(&unicodeFont->bitmapFormat);
+    }
+public:
+    UnicodeFontLookup() : unicodeFont(nullptr) {}
+
+    /**
+     * Optionally put a glyph cache in front of the font lookup, it is keyed by font so there is no need to clear it
+     * when changing fonts. This object will not delete the cache, and a cache should not be shared between handlers
+     * that render at the same time on different tasks or cores.
+     * @param cache the glyph cache to use, or nullptr to look up every glyph in the font
+     */
+    void setGlyphCache(UnicodeGlyphCache *cache) { glyphCache = cache; }
+
+    /**
+     * @return the glyph cache in use, or nullptr if there is none.
+     */
+    UnicodeGlyphCache *getGlyphCache() { return glyphCache; }
+
+    /**
+     * Finds a character in the current font, if the character exists it will return true, and the referenced value
+     * type (GlyphWithBitmap) will be filled in. Note that the returned glyph is always accessible without progmem
+     * functions on any board. Whereas the bitmap will be in constant memory, so could we require progmem functions.
+     * The glyph is copied into the GlyphWithBitmap provided, so this function is reentrant.
+     * @param ch the character to find.
+     * @param glyphBitmap a reference to a structure holding the Glyph and bitmap pointer. Only valid when true returned
+     * @return true if successful, otherwise false.
+     */
+    bool findCharInFont(uint32_t ch, GlyphWithBitmap &glyphBitmap) const;
+
+    /**
+    * Get the extent of a single unicode character
+    * @param theChar the unicode character to get the extent of
+    * @return the x and y extent of the character
+    */
+    Coord textExtent(uint32_t theChar);
+
+    /**
+    * Get the absolute baseline of the font, this is the total height including any parts considered below
+    * the yheight.
+    * @return the baseline
+    */
+    int getBaseline();
+
+    /**
+     * @return the total Y advance to move down a line. Call get baseline to get the amount below the baseline.
+     */
+    int getYAdvance() const {
+        if(adaFont == nullptr) return 0;
+        return pgm_read_byte((fontAdafruit ? &adaFont->yAdvance : &unicodeFont->yAdvance));
+    }
+};
+
+/**
+ * Draws UTF-8 text onto a display through a pipeline whose type is fixed at compile time. Every call into the pipeline
+ * binds directly to that type (see PipelineCalls), so the compiler can inline the pixel and span writes instead of
+ * making a virtual call for each one, which on AVR and ESP8266 costs more than setting the pixel. The pipeline needs
+ * the same functions as TextPlotPipeline but does not have to derive from it, one that does must be declared final,
+ * as the pipelines in this library are. For example:
+ *
+ * ```
+ * AdafruitTextPlotPipeline pipeline(&gfx);
+ * BasicUnicodeFontHandler<AdafruitTextPlotPipeline> fontHandler(&pipeline, ENCMODE_UTF8);
+ * ```
+ *
+ * `UnicodeFontHandler` is this class over the virtual TextPlotPipeline, it can draw onto any pipeline and is the
+ * type that other code accepts, so only use this directly where text drawing speed matters.
+ */
 #if __has_include (<Print.h>) || defined(ARDUINO_SAM_DUE)
-#include <Print.h>
-class UnicodeFontHandler : public Print {
+template<typename Pipeline> class BasicUnicodeFontHandler : public Print, public UnicodeFontLookup {
 #elif __has_include(<PrintCompat.h>)
-#include <PrintCompat.h>
-class UnicodeFontHandler : public Print {
+template<typename Pipeline> class BasicUnicodeFontHandler : public Print, public UnicodeFontLookup {
 #else
-class UnicodeFontHandler {
+template<typename Pipeline> class BasicUnicodeFontHandler : public UnicodeFontLookup {
 #endif
 
 public:
     enum HandlerMode {
         HANDLER_SIZING_TEXT, HANDLER_DRAWING_TEXT
     };
+    typedef void (*GlyphRasterFunction)(Pipeline* plotter, const GlyphPlacement& placement, uint32_t color);
 private:
-    tccore::Utf8TextProcessor utf8;
-    TextPlotPipeline *plotter;
-    union {
-        const UnicodeFont *unicodeFont;
-        const GFXfont *adaFont;
+    /**
+     * Receives each character from the UTF-8 decoder, binding it at compile time so that decoding, lookup and drawing
+     * can all be inlined together.
+     */
+    struct FontHandlerSink {
+        BasicUnicodeFontHandler* fontHandler;
+        void operator()(uint32_t ch) const { fontHandler->internalHandleUnicodeFont(ch); }
     };
-    bool fontAdafruit = false;
+
+    tccore::BasicUtf8TextProcessor<FontHandlerSink> utf8;
+    Pipeline *plotter;
+    GlyphRasterFunction glyphRaster = nullptr;
+    GlyphSpanCache *spanCache = nullptr;
+    bool fontSpanCacheable = false;
+    bool opaqueText = false;
+    uint32_t backgroundColor = 0;
     HandlerMode handlerMode = HANDLER_DRAWING_TEXT;
     uint16_t xExtentCurrent = 0;
-    int16_t calculatedBaseline = -1;
     uint32_t drawColor = 0;
+    bool pastRightEdge = false;
 public:
     /**
      * Create a UnicodeFontHandler with a given pipeline, the pipeline interfaces with the underlying library and provides
      * the drawing support. It is the minimum possible code to draw text. It also takes an encoding mode which is passed
-     * to the underlying UTF-8 encoder, either `ENCMODE_UTF8` or `ENCMODE_EXT_ASCII`. This object will not delete the
+     * to the underlying UTF-8 encoder, either `ENCMODE_UTF8`, `ENCMODE_UTF8_TABLE` or `ENCMODE_EXT_ASCII`. This object will not delete the
      * underlying plotter that you pass in, you must do that yourself if this object is not global in scope. See the examples
      * for more details on usage with libraries.
      *
      * @param plotter the pipeline plotter pointer
      * @param mode the encoding mode
      */
-    explicit UnicodeFontHandler(TextPlotPipeline *plotter, tccore::UnicodeEncodingMode mode) : utf8(handleUtf8Drawing, this, mode),
-                                                                                               plotter(plotter),
-                                                                                               unicodeFont(nullptr) {}
-    virtual ~UnicodeFontHandler() = default;
+    explicit BasicUnicodeFontHandler(Pipeline *plotter, tccore::UnicodeEncodingMode mode) : utf8(FontHandlerSink{this}, mode),
+                                                                                            plotter(plotter) {}
+    virtual ~BasicUnicodeFontHandler() = default;
 
     /**
      * Plotter pipelines allow the rendering of fonts to be customized to a greater extent, for example a transformation
      * pipeline could be added as a kind of passthrough.
      * @return  the current plotter
      */
-    TextPlotPipeline *getTextPlotPipeline() { return plotter; }
+    Pipeline *getTextPlotPipeline() { return plotter; }
 
     /**
      * Set a new pipeline as the means of plotting onto the display
      * @param newPipeline the new pipeline
      */
-    void setTextPlotPipeline(TextPlotPipeline *newPipeline) { plotter = newPipeline; }
+    void setTextPlotPipeline(Pipeline *newPipeline) { plotter = newPipeline; }
 
     /**
-    * Sets the font to be a TcUnicode font
+     * When the handler is in `ENCMODE_EXT_ASCII` mode, sets the code page that turns bytes 0x80 to 0xFF into unicode
+     * characters, so that text in a legacy single byte encoding renders with the unicode glyphs of the font. See
+     * Utf8CodePages.h for the tables that are provided.
+     * @param table a 128 entry code page table in PROGMEM, or nullptr to pass bytes through unchanged
+     */
+    void setCodePage(const uint16_t *table) { utf8.setCodePage(table); }
+
+    /**
+    * Sets the font to be a TcUnicode font, the glyph lookup and rasterizer for the font are chosen here.
     * @param font a tcUnicode font
     */
     void setFont(const UnicodeFont *font) {
-        unicodeFont = font;
-        fontAdafruit = false;
-        calculatedBaseline = -1;
+        selectFont(font);
+        glyphRaster = glyphRasterizerFor<Pipeline>(currentBitmapFormat());
+        fontSpanCacheable = currentBitmapFormat() == TCFONT_ONE_BIT_PER_PIXEL;
     }
 
     /**
-    * sets the font to be an Adafruit font
+    * sets the font to be an Adafruit font, the glyph lookup and rasterizer for the font are chosen here.
     * @param font an adafruit font
     */
     void setFont(const GFXfont *font) {
-        adaFont = font;
-        fontAdafruit = true;
-        calculatedBaseline = -1;
+        selectFont(font);
+        glyphRaster = glyphRasterizerFor<Pipeline>(TCFONT_ONE_BIT_PER_PIXEL);
+        fontSpanCacheable = true;
     }
 
+    /**
+     * Provide a span cache, which keeps recently drawn glyphs decoded into spans in RAM so that drawing them again
+     * skips decoding their bitmaps, see GlyphSpanCache. Glyphs of every font share it. This is worthwhile when the same
+     * characters are redrawn often, for example a status line. Glyphs are drawn from the cache as spans, rather than
+     * offered to the pipeline as a bitmap. The handler does not take ownership, the cache must outlive its use here.
+     * @param cache the cache to use, or nullptr to turn span caching off
+     */
+    void setSpanCache(GlyphSpanCache *cache) { spanCache = cache; }
+
+    /**
+     * @return the span cache in use, or nullptr if there is none
+     */
+    GlyphSpanCache *getSpanCache() { return spanCache; }
+
     /**
      * Set the cursor position where the next text will be drawn, depending on the library this may also change the
      * cursor for the library.
      * @param x the x position
      * @param y the y position
      */
-    void setCursor(int16_t x, int16_t y) { plotter->setCursor(Coord(x, y)); }
+    void setCursor(int16_t x, int16_t y) { PipelineCalls<Pipeline>::setCursor(plotter, Coord(x, y)); }
 
     /**
      * Set the cursor position where the next text will be drawn, depending on the library this may also change the
      * cursor for the library.
      * @param where the new position
      */
-    void setCursor(const Coord& where) { plotter->setCursor(where); }
+    void setCursor(const Coord& where) { PipelineCalls<Pipeline>::setCursor(plotter, where); }
 
     /**
     * Set the drawing color
@@ -228,6 +784,25 @@ public:
     */
     void setDrawColor(uint32_t color) { this->drawColor = color; }
 
+    /**
+     * Set the background color that is used when opaque text is turned on, see `setOpaqueText`.
+     * @param color the new background color for text drawing
+     */
+    void setBackgroundColor(uint32_t color) { this->backgroundColor = color; }
+
+    /**
+     * Turn opaque text on or off, it is off by default. When on, each character paints its whole cell, which is its x
+     * advance wide and the line height (y advance) tall with the baseline at the cursor position, the set bits in the
+     * draw color and the rest in the background color. There is then no need to clear the area before printing, and
+     * it is drawn in one pass. The part of a glyph that reaches outside its cell, such as the tail of a 'j', is drawn
+     * in the draw color only, so it does not paint over the character next to it, but a following cell's background
+     * covers ink that reaches forward into it. Pipelines that support `beginPixelWindow` stream the cell straight to
+     * the display, others draw it as spans. Only the cells are painted, so when text becomes shorter, clear the rest
+     * of the line yourself.
+     * @param opaque true to paint the background of each character, false to only draw the set bits.
+     */
+    void setOpaqueText(bool opaque) { this->opaqueText = opaque; }
+
     /**
     * Prints a unicode character using the current font
     * @param unicodeChar the character to print.
@@ -267,11 +842,41 @@ public:
 #endif
 
     /**
-    * Get the extent of a single unicode character
-    * @param theChar the unicode character to get the extent of
-    * @return the x and y extent of the character
-    */
-    Coord textExtent(uint32_t theChar);
+     * Get the extents of text that is already decoded into unicode characters, for example text decoded at compile
+     * time with TC_UTF8_LITERAL, no UTF-8 decoding takes place.
+     * @param chars the unicode characters
+     * @param count the number of characters
+     * @param baseline the pointer to int for the baseline (amount below text), can be nullptr.
+     * @return the x and y extent of the text
+     */
+    Coord textExtents(const uint32_t *chars, size_t count, int *baseline);
+
+    /**
+     * Draws text that is already decoded into unicode characters at the current cursor position, for example text
+     * decoded at compile time with TC_UTF8_LITERAL, no UTF-8 decoding takes place.
+     * @param chars the unicode characters
+     * @param count the number of characters
+     */
+    void printCodePoints(const uint32_t *chars, size_t count);
+
+    /**
+     * Draws whatever text is available from a source, such as an Arduino Stream, reading it in small chunks straight
+     * into the decoder without copying it into a buffer first. It never waits for data, so call it each time around
+     * the loop, a sequence split between calls is drawn once the rest of it arrives. Include Utf8StreamSource.h
+     * before calling this, it is not included by this header.
+     * @param source anything with `int available()` and `size_t readBytes(char*, size_t)`, see Utf8StreamSource.h
+     * @param maxBytes the most bytes to read in this call
+     * @return the number of bytes read from the source
+     */
+    template<typename Source> size_t printFromSource(Source& source, size_t maxBytes = (size_t)-1) {
+        if(adaFont == nullptr) return 0;
+        handlerMode = HANDLER_DRAWING_TEXT;
+        pastRightEdge = false;
+        // found in tccore by argument lookup when this is instantiated, so only users of it need Utf8StreamSource.h
+        size_t read = utf8DrainIntoDecoder(source, utf8, maxBytes);
+        pastRightEdge = false;
+        return read;
+    }
 
     /**
     * An extension to the print interface that allows printing from program memory somewhat easier
@@ -280,13 +885,6 @@ public:
     */
     size_t print_P(const char *textPgm);
 
-    /**
-    * Get the absolute baseline of the font, this is the total height including any parts considered below
-    * the yheight.
-    * @return the baseline
-    */
-    int getBaseline();
-
     /**
     * Can be used to implement the print interface, the UTF8 implementation for this library is completely
     * asynchronous and keeps internal state, so it will wait until enough characters arrive to actually print
@@ -295,28 +893,298 @@ public:
     */
     size_t write(uint8_t data) override;
 
+#if __has_include (<Print.h>) || defined(ARDUINO_SAM_DUE)
+    using Print::write;
     /**
-     * Finds a character in the current font, if the character exists it will return true, and the referenced value
-     * type (GlyphWithBitmap) will be filled in. Note that the returned glyph is always accessible without progmem
-     * functions on any board. Whereas the bitmap will be in constant memory, so could we require progmem functions.
-     * @param ch the character to find.
-     * @param glyphBitmap a reference to a structure holding the Glyph and bitmap pointer. Only valid when true returned
-     * @return true if successful, otherwise false.
-     */
-    bool findCharInFont(uint32_t ch, GlyphWithBitmap &glyphBitmap) const;
-    /**
-     * @return the total Y advance to move down a line. Call get baseline to get the amount below the baseline.
+     * Implements the buffer version of the print interface, the buffer is decoded in bulk, and once the cursor moves
+     * past the right edge of the display nothing further can be visible, so the rest of the buffer is not drawn.
+     * @param buffer the UTF-8 data to print
+     * @param size the number of bytes in the buffer
+     * @return the number of bytes consumed, which is always size
      */
-    int getYAdvance() const {
-        if(adaFont == nullptr) return 0;
-        return pgm_read_byte((fontAdafruit ? &adaFont->yAdvance : &unicodeFont->yAdvance));
-    }
+    size_t write(const uint8_t *buffer, size_t size) override;
+#endif
 
     /**
      * Internal function called by the utf8 async callback
      * @param ch the unicode char
      */
     void internalHandleUnicodeFont(uint32_t ch);
+private:
+    template<typename SpanFunction> bool forEachCachedSpan(uint32_t code, const GlyphPlacement& placement, SpanFunction spanFn);
+    template<typename SpanFunction> void forEachVisibleSpan(uint32_t code, const GlyphPlacement& placement, SpanFunction spanFn);
+    void drawOpaqueCell(uint32_t code, const GlyphWithBitmap& gb, const Coord& posn, const Coord& dims);
+};
+
+template<typename Pipeline> Coord BasicUnicodeFontHandler<Pipeline>::textExtents(const char *text, int *baseline, bool progMem) {
+    if(adaFont == nullptr) {
+        baseline = 0;
+        return Coord(0,0);
+    }
+
+    handlerMode = HANDLER_SIZING_TEXT;
+    xExtentCurrent = 0;
+    utf8.reset();
+    if(progMem) {
+        uint8_t c;
+        while ((c = pgm_read_byte(text++))) utf8.pushChar((char)c);
+    } else {
+        utf8.pushChars(text);
+    }
+    handlerMode = HANDLER_DRAWING_TEXT;
+
+    if(baseline) {
+        *baseline = getBaseline();
+    }
+    return Coord((int)xExtentCurrent, getYAdvance());
+}
+
+template<typename Pipeline> Coord BasicUnicodeFontHandler<Pipeline>::textExtents(const uint32_t *chars, size_t count, int *baseline) {
+    if(adaFont == nullptr) {
+        return Coord(0,0);
+    }
+
+    int xExtent = 0;
+    for (size_t i = 0; i < count; i++) {
+        xExtent += textExtent(chars[i]).x;
+    }
+
+    if(baseline) {
+        *baseline = getBaseline();
+    }
+    return Coord(xExtent, getYAdvance());
+}
+
+template<typename Pipeline> void BasicUnicodeFontHandler<Pipeline>::printCodePoints(const uint32_t *chars, size_t count) {
+    if(adaFont == nullptr) return;
+
+    pastRightEdge = false;
+    for (size_t i = 0; i < count && !pastRightEdge; i++) {
+        writeUnicode(chars[i]);
+    }
+    pastRightEdge = false;
+}
+
+template<typename Pipeline> void BasicUnicodeFontHandler<Pipeline>::writeUnicode(uint32_t unicodeText) {
+    // make sure it's printable, once past the right edge nothing else on this line can be seen.
+    auto dims = PipelineCalls<Pipeline>::getDimensions(plotter);
+    auto posn = PipelineCalls<Pipeline>::getCursor(plotter);
+    if (posn.x > dims.x) {
+        pastRightEdge = true;
+        return;
+    }
+
+    GlyphWithBitmap gb;
+    if(!findCharInFont(unicodeText, gb)) return;
+    auto glyph = gb.getGlyph();
+    if (opaqueText) {
+        drawOpaqueCell(unicodeText, gb, posn, dims);
+        PipelineCalls<Pipeline>::setCursor(plotter, Coord(posn.x + glyph->xAdvance, posn.y));
+        return;
+    }
+    int w = glyph->width, h = glyph->height;
+    int left = posn.x + glyph->xOffset;
+    int top = posn.y + glyph->yOffset;
+
+    // work out the visible part of the glyph once, rows and columns are relative to the glyph origin.
+    int firstCol = (left < 0) ? -left : 0;
+    int endCol = (dims.x - left < w) ? dims.x - left : w;
+    int firstRow = (top < 0) ? -top : 0;
+    int endRow = (dims.y - top < h) ? dims.y - top : h;
+
+    if (firstCol < endCol && firstRow < endRow && glyphRaster != nullptr) {
+        GlyphPlacement placement = { gb.getBitmapData(), (int16_t)left, (int16_t)top, (uint8_t)w, (uint8_t)h,
+                                     (uint8_t)firstCol, (uint8_t)endCol, (uint8_t)firstRow, (uint8_t)endRow };
+        bool drawnFromCache = fontSpanCacheable && forEachCachedSpan(unicodeText, placement, [this](int x, int y, int len) {
+            PipelineCalls<Pipeline>::drawHorizontalSpan(plotter, x, y, len, drawColor);
+        });
+        if (!drawnFromCache) glyphRaster(plotter, placement, drawColor);
+    }
+    PipelineCalls<Pipeline>::setCursor(plotter, Coord(posn.x + glyph->xAdvance, posn.y));
+}
+
+template<typename Pipeline> template<typename SpanFunction>
+bool BasicUnicodeFontHandler<Pipeline>::forEachCachedSpan(uint32_t code, const GlyphPlacement& placement, SpanFunction spanFn) {
+    if (spanCache == nullptr || !spanCache->isEnabled()) return false;
+    uint16_t spanCount;
+    const GlyphSpan* spans = spanCache->findSpans(adaFont, code, spanCount);
+    if (spans == nullptr) {
+        spans = spanCache->storeSpans(adaFont, code, placement.bitmap, placement.width, placement.height, spanCount);
+        if (spans == nullptr) return false;
+    }
+
+    // the spans are for the whole glyph, so they are clipped to the visible part here, they are in row order.
+    for (uint16_t i = 0; i < spanCount && spans[i].row < placement.endRow; i++) {
+        if (spans[i].row < placement.firstRow) continue;
+        int start = (spans[i].col < placement.firstCol) ? placement.firstCol : spans[i].col;
+        int end = (spans[i].col + spans[i].length > placement.endCol) ? placement.endCol : spans[i].col + spans[i].length;
+        if (start < end) spanFn(placement.left + start, placement.top + spans[i].row, end - start);
+    }
+    return true;
+}
+
+template<typename Pipeline> template<typename SpanFunction>
+void BasicUnicodeFontHandler<Pipeline>::forEachVisibleSpan(uint32_t code, const GlyphPlacement& placement, SpanFunction spanFn) {
+    if (forEachCachedSpan(code, placement, spanFn)) return;
+    forEachGlyphSpan(placement.bitmap, placement.width, placement.firstRow, placement.endRow,
+                     [&](uint8_t col, uint8_t row, uint8_t len) {
+        int start = (col < placement.firstCol) ? placement.firstCol : col;
+        int end = (col + len > placement.endCol) ? placement.endCol : col + len;
+        if (start < end) spanFn(placement.left + start, placement.top + row, end - start);
+    });
+}
+
+template<typename Pipeline> void BasicUnicodeFontHandler<Pipeline>::drawOpaqueCell(uint32_t code, const GlyphWithBitmap& gb,
+                                                                                   const Coord& posn, const Coord& dims) {
+    // the cell is the advance by the line height with the baseline at the cursor, limited to the display.
+    auto glyph = gb.getGlyph();
+    int cellTop = posn.y - getYAdvance() + getBaseline();
+    int cellRight = posn.x + glyph->xAdvance;
+    int cellBottom = cellTop + getYAdvance();
+    int x0 = (posn.x < 0) ? 0 : posn.x;
+    int y0 = (cellTop < 0) ? 0 : cellTop;
+    int x1 = (cellRight > dims.x) ? dims.x : cellRight;
+    int y1 = (cellBottom > dims.y) ? dims.y : cellBottom;
+    bool cellVisible = x0 < x1 && y0 < y1;
+    int left = posn.x + glyph->xOffset;
+    int top = posn.y + glyph->yOffset;
+
+    if (cellVisible) {
+        uint16_t windowWidth = x1 - x0;
+        uint32_t windowSize = (uint32_t)windowWidth * (y1 - y0);
+
+        // the set bits of the glyph that fall within the cell, rows and columns are relative to the glyph origin.
+        int firstCol = (x0 - left > 0) ? x0 - left : 0;
+        int endCol = (x1 - left < glyph->width) ? x1 - left : glyph->width;
+        int firstRow = (y0 - top > 0) ? y0 - top : 0;
+        int endRow = (y1 - top < glyph->height) ? y1 - top : glyph->height;
+
+        // the window is filled in order, so each span is preceded by the background since the end of the last one,
+        // and that background carries on from one row to the next without a break.
+        bool window = PipelineCalls<Pipeline>::beginPixelWindow(plotter, x0, y0, windowWidth, y1 - y0);
+        PixelWindowCursor spanCursor;
+        spanCursor.begin(x0, y0, windowWidth);
+        uint32_t filled = 0;
+        auto pushRun = [&](uint32_t color, uint32_t count) {
+            if (count == 0) return;
+            if (window) {
+                PipelineCalls<Pipeline>::pushPixels(plotter, color, count);
+            } else {
+                spanCursor.push(color, count, [this](uint16_t x, uint16_t y, uint16_t len, uint32_t c) {
+                    PipelineCalls<Pipeline>::drawHorizontalSpan(plotter, x, y, len, c);
+                });
+            }
+            filled += count;
+        };
+        auto pushSpan = [&](int x, int y, int len) {
+            pushRun(backgroundColor, ((uint32_t)(y - y0) * windowWidth) + (x - x0) - filled);
+            pushRun(drawColor, len);
+        };
+
+        if (firstCol < endCol && firstRow < endRow && fontSpanCacheable) {
+            GlyphPlacement placement = { gb.getBitmapData(), (int16_t)left, (int16_t)top, glyph->width, glyph->height,
+                                         (uint8_t)firstCol, (uint8_t)endCol, (uint8_t)firstRow, (uint8_t)endRow };
+            forEachVisibleSpan(code, placement, pushSpan);
+        }
+        pushRun(backgroundColor, windowSize - filled);
+        if (window) PipelineCalls<Pipeline>::endPixelWindow(plotter);
+    }
+
+    // glyphs such as 'j' reach outside their cell, that part is drawn in the foreground only, so that it does not
+    // paint over the characters either side of it.
+    bool overhangs = left < posn.x || left + glyph->width > cellRight || top < cellTop || top + glyph->height > cellBottom;
+    if (!overhangs || !fontSpanCacheable) return;
+    int firstCol = (left < 0) ? -left : 0;
+    int endCol = (dims.x - left < glyph->width) ? dims.x - left : glyph->width;
+    int firstRow = (top < 0) ? -top : 0;
+    int endRow = (dims.y - top < glyph->height) ? dims.y - top : glyph->height;
+    if (firstCol >= endCol || firstRow >= endRow) return;
+
+    GlyphPlacement placement = { gb.getBitmapData(), (int16_t)left, (int16_t)top, glyph->width, glyph->height,
+                                 (uint8_t)firstCol, (uint8_t)endCol, (uint8_t)firstRow, (uint8_t)endRow };
+    forEachVisibleSpan(code, placement, [&](int x, int y, int len) {
+        int end = x + len;
+        if (!cellVisible || y < y0 || y >= y1) {
+            PipelineCalls<Pipeline>::drawHorizontalSpan(plotter, x, y, len, drawColor);
+            return;
+        }
+        if (x < x0) PipelineCalls<Pipeline>::drawHorizontalSpan(plotter, x, y, ((end < x0) ? end : x0) - x, drawColor);
+        if (end > x1) {
+            int start = (x > x1) ? x : x1;
+            PipelineCalls<Pipeline>::drawHorizontalSpan(plotter, start, y, end - start, drawColor);
+        }
+    });
+}
+
+template<typename Pipeline> void BasicUnicodeFontHandler<Pipeline>::internalHandleUnicodeFont(uint32_t ch) {
+    if (ch == TC_UNICODE_CHAR_ERROR) {
+        utf8.reset();
+        return;
+    }
+
+    switch(handlerMode) {
+        case HANDLER_SIZING_TEXT:
+            xExtentCurrent += textExtent(ch).x;
+            break;
+        case HANDLER_DRAWING_TEXT:
+            if (!pastRightEdge) writeUnicode(ch);
+            break;
+    }
+}
+
+template<typename Pipeline> size_t BasicUnicodeFontHandler<Pipeline>::write(uint8_t data) {
+    if(adaFont == nullptr) return 0;
+
+    handlerMode = HANDLER_DRAWING_TEXT;
+    pastRightEdge = false;
+    utf8.pushChar((char)data);
+    return 1;
+}
+
+#if __has_include (<Print.h>) || defined(ARDUINO_SAM_DUE)
+template<typename Pipeline> size_t BasicUnicodeFontHandler<Pipeline>::write(const uint8_t *buffer, size_t size) {
+    if(adaFont == nullptr) return 0;
+
+    handlerMode = HANDLER_DRAWING_TEXT;
+    pastRightEdge = false;
+    utf8.pushChars((const char*)buffer, size);
+    pastRightEdge = false;
+    return size;
+}
+#endif
+
+template<typename Pipeline> size_t BasicUnicodeFontHandler<Pipeline>::print_P(const char *textPgm) {
+    if(adaFont == nullptr) return 0;
+    uint8_t c;
+    size_t count= 0;
+    pastRightEdge = false;
+    while ((c = pgm_read_byte(textPgm++))) {
+        if (!pastRightEdge) utf8.pushChar((char)c);
+        count++;
+    }
+    pastRightEdge = false;
+    return count;
+}
+
+extern template class BasicUnicodeFontHandler<TextPlotPipeline>;
+
+/**
+ * The font handler that draws through the virtual TextPlotPipeline, so that it works with any pipeline, this is the
+ * handler that the examples and other libraries use. See BasicUnicodeFontHandler for one bound to a pipeline type.
+ */
+class UnicodeFontHandler : public BasicUnicodeFontHandler<TextPlotPipeline> {
+public:
+    /**
+     * Create a UnicodeFontHandler with a given pipeline, the pipeline interfaces with the underlying library and provides
+     * the drawing support. It also takes an encoding mode which is passed to the underlying UTF-8 encoder, either
+     * `ENCMODE_UTF8`, `ENCMODE_UTF8_TABLE` or `ENCMODE_EXT_ASCII`. This object will not delete the underlying plotter
+     * that you pass in, you must do that yourself if this object is not global in scope.
+     *
+     * @param plotter the pipeline plotter pointer
+     * @param mode the encoding mode
+     */
+    explicit UnicodeFontHandler(TextPlotPipeline *plotter, tccore::UnicodeEncodingMode mode)
+            : BasicUnicodeFontHandler<TextPlotPipeline>(plotter, mode) {}
 };
 
 using namespace tccore;
@@ -17,7 +17,7 @@
 
 namespace tcgfx {
 
-    class TftSpiTextPlotPipeline : public TextPlotPipeline {
+    class TftSpiTextPlotPipeline final : public TextPlotPipeline {
     private:
         TFT_eSPI* tft;
         Coord cursor;
@@ -25,6 +25,27 @@ namespace tcgfx {
         TftSpiTextPlotPipeline(TFT_eSPI* tft) : tft(tft) {}
         ~TftSpiTextPlotPipeline()=default;
         void drawPixel(uint16_t x, uint16_t y, uint32_t dc) override { return tft->drawPixel(x, y, dc); }
+        void drawHorizontalSpan(uint16_t x, uint16_t y, uint16_t length, uint32_t dc) override { tft->drawFastHLine(x, y, length, dc); }
+        bool drawMonoBitmap(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint8_t* bits, uint32_t dc) override {
+            if ((w & 7) == 0) {
+                // with a whole number of bytes per row the packed glyph is the same as the row padded bitmap format
+                tft->drawBitmap(x, y, bits, w, h, dc);
+            } else {
+                tft->startWrite();
+                forEachGlyphSpan(bits, w, h, [&](uint8_t col, uint8_t row, uint8_t len) {
+                    tft->drawFastHLine(x + col, y + row, len, dc);
+                });
+                tft->endWrite();
+            }
+            return true;
+        }
+        bool beginPixelWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) override {
+            tft->startWrite();
+            tft->setAddrWindow(x, y, w, h);
+            return true;
+        }
+        void pushPixels(uint32_t dc, uint32_t count) override { tft->pushBlock(dc, count); }
+        void endPixelWindow() override { tft->endWrite(); }
         Coord getDimensions() override { return Coord(tft->width(), tft->height());}
         void setCursor(const Coord& where) override { cursor = where; }
         Coord getCursor() override { return cursor; }
@@ -19,7 +19,7 @@ namespace tcgfx {
 
 #define UNICODE_U8G2_AVAILABLE
 
-    class U8g2TextPlotPipeline : public TextPlotPipeline {
+    class U8g2TextPlotPipeline final : public TextPlotPipeline {
     private:
         U8G2 *u8g2;
         Coord cursor;
@@ -33,6 +33,20 @@ namespace tcgfx {
             u8g2->drawPixel(x, y);
         }
 
+        void drawHorizontalSpan(uint16_t x, uint16_t y, uint16_t length, uint32_t color) override {
+            u8g2->setColorIndex(color);
+            u8g2->drawHLine(x, y, length);
+        }
+
+        bool drawMonoBitmap(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint8_t* bits, uint32_t color) override {
+            // XBM bitmaps are least significant bit first and row padded, so decode runs straight into the buffer
+            u8g2->setColorIndex(color);
+            forEachGlyphSpan(bits, w, h, [&](uint8_t col, uint8_t row, uint8_t len) {
+                u8g2->drawHLine(x + col, y + row, len);
+            });
+            return true;
+        }
+
         Coord getDimensions() override { return Coord(u8g2->getWidth(), u8g2->getHeight()); }
 
         void setCursor(const Coord &where) override { cursor = where; }
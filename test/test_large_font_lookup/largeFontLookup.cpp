@@ -0,0 +1,128 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <tcUnicodeHelper.h>
+
+//
+// Generates a CJK sized font in memory and checks that lookup is correct and stays fast as the number of blocks grows.
+// All blocks share one glyph table containing every other character, so each block is sparse and is searched, while
+// the whole font still holds 20480 glyphs in only a few kilobytes.
+//
+
+const uint16_t glyphsPerBlock = 128;
+const uint16_t largeFontBlocks = 160;
+const uint32_t largeFontStart = 0x4E00;
+
+class NullPlotter : public TextPlotPipeline {
+public:
+    void drawPixel(uint16_t x, uint16_t y, uint32_t color) override {}
+    void setCursor(const Coord &p) override {}
+    Coord getCursor() override { return Coord(0, 0); }
+    Coord getDimensions() override { return Coord(320, 200); }
+} nullPlotter;
+
+enum BlockLayout { SORTED_GLYPHS, SORTED_KEYS, EYTZINGER_GLYPHS, EYTZINGER_KEYS };
+const char* layoutNames[] = { "sorted glyphs", "sorted keys", "eytzinger glyphs", "eytzinger keys" };
+
+const uint8_t sharedBitmap[] = { 0xff };
+UnicodeFontGlyph sharedGlyphs[glyphsPerBlock];
+UnicodeFontGlyph eytzingerGlyphs[glyphsPerBlock];
+uint16_t sortedKeys[glyphsPerBlock];
+uint16_t eytzingerKeys[glyphsPerBlock];
+UnicodeFontBlock* generatedBlocks = nullptr;
+UnicodeFont generatedFont[1];
+UnicodeFontHandler* handler = nullptr;
+
+void generateFont(uint16_t numBlocks, BlockLayout layout = SORTED_GLYPHS) {
+    for (uint16_t i = 0; i < glyphsPerBlock; i++) {
+        sharedGlyphs[i] = { (uint16_t)(i * 2), 0, 1, 1, (uint8_t)(i % 20), 0, -1 };
+    }
+    tcUnicodeBuildGlyphKeys(sharedGlyphs, glyphsPerBlock, sortedKeys);
+    tcUnicodeEytzingerLayout(sharedGlyphs, glyphsPerBlock, eytzingerGlyphs, eytzingerKeys);
+    bool eytzinger = layout == EYTZINGER_GLYPHS || layout == EYTZINGER_KEYS;
+    const UnicodeFontGlyph* glyphs = eytzinger ? eytzingerGlyphs : sharedGlyphs;
+    const uint16_t* keys = nullptr;
+    if (layout == SORTED_KEYS) keys = sortedKeys;
+    if (layout == EYTZINGER_KEYS) keys = eytzingerKeys;
+    uint8_t flags = eytzinger ? TCFONT_BLOCK_EYTZINGER : 0;
+    delete[] generatedBlocks;
+    generatedBlocks = new UnicodeFontBlock[numBlocks];
+    for (uint16_t i = 0; i < numBlocks; i++) {
+        // reverse order of starting code, the same as the designer generates
+        uint32_t start = largeFontStart + ((numBlocks - i - 1) * 256U);
+        generatedBlocks[i] = { start, sharedBitmap, glyphs, 256, glyphsPerBlock, flags, keys };
+    }
+    generatedFont[0] = { generatedBlocks, numBlocks, 20, TCFONT_ONE_BIT_PER_PIXEL };
+}
+
+void setUp() {
+    handler = new UnicodeFontHandler(&nullPlotter, ENCMODE_UTF8);
+}
+
+void tearDown() {
+    delete handler;
+}
+
+void checkEveryGlyphFound(BlockLayout layout) {
+    printf("Checking layout %s\n", layoutNames[layout]);
+    generateFont(largeFontBlocks, layout);
+    handler->setFont(generatedFont);
+    GlyphWithBitmap gb;
+    uint32_t found = 0;
+    for (uint32_t code = largeFontStart; code < largeFontStart + (largeFontBlocks * 256U); code++) {
+        bool present = ((code - largeFontStart) % 2) == 0;
+        TEST_ASSERT_EQUAL(present, handler->findCharInFont(code, gb));
+        if (present) {
+            TEST_ASSERT_EQUAL(((code - largeFontStart) % 256) / 2 % 20, gb.getGlyph()->xAdvance);
+            found++;
+        }
+    }
+    TEST_ASSERT_EQUAL(largeFontBlocks * glyphsPerBlock, found);
+    TEST_ASSERT_FALSE(handler->findCharInFont(largeFontStart - 2, gb));
+    TEST_ASSERT_FALSE(handler->findCharInFont(largeFontStart + (largeFontBlocks * 256U) + 2, gb));
+    TEST_ASSERT_FALSE(handler->findCharInFont('A', gb));
+}
+
+void testEveryGlyphFoundInLargeFont() {
+    checkEveryGlyphFound(SORTED_GLYPHS);
+    checkEveryGlyphFound(SORTED_KEYS);
+    checkEveryGlyphFound(EYTZINGER_GLYPHS);
+    checkEveryGlyphFound(EYTZINGER_KEYS);
+}
+
+unsigned long timeLookups(uint16_t numBlocks, uint32_t lookups, BlockLayout layout) {
+    generateFont(numBlocks, layout);
+    handler->setFont(generatedFont);
+    GlyphWithBitmap gb;
+    uint32_t range = numBlocks * 256U;
+    uint32_t step = 7919; // prime, so that lookups wander all over the font
+    uint32_t offset = 0;
+    unsigned long start = micros();
+    for (uint32_t i = 0; i < lookups; i++) {
+        offset = (offset + step) % range;
+        handler->findCharInFont(largeFontStart + (offset & ~1U), gb);
+    }
+    return micros() - start;
+}
+
+void testLookupBenchmarkAcrossFontSizes() {
+    const uint32_t lookups = 20000;
+    const uint16_t blockCounts[] = {2, 8, 20, 40, 80, 160};
+    for (uint16_t blocks : blockCounts) {
+        for (int layout = SORTED_GLYPHS; layout <= EYTZINGER_KEYS; layout++) {
+            unsigned long took = timeLookups(blocks, lookups, (BlockLayout)layout);
+            printf("Lookup benchmark: %d blocks, %u glyphs, %s, %u lookups took %lu us\n", blocks,
+                   (unsigned)(blocks * glyphsPerBlock), layoutNames[layout], (unsigned)lookups, took);
+        }
+    }
+    delete[] generatedBlocks;
+    generatedBlocks = nullptr;
+}
+
+void setup() {
+    UNITY_BEGIN();
+    RUN_TEST(testEveryGlyphFoundInLargeFont);
+    RUN_TEST(testLookupBenchmarkAcrossFontSizes);
+    UNITY_END();
+}
+
+void loop() {}
@@ -2,9 +2,12 @@
 #include <Arduino.h>
 #include <unity.h>
 #include <deque>
+#include <vector>
+#include <algorithm>
 #include <Fonts/OpenSansCyrillicLatin18.h>
 #include <Fonts/RobotoMedium24.h>
 #include <tcUnicodeHelper.h>
+#include <Utf8StreamSource.h>
 
 class UnitTestPlotter : public TextPlotPipeline {
 private:
@@ -41,6 +44,66 @@ public:
     }
 } unitTestPlotter;
 
+/**
+ * Records every pixel that is drawn, either directly or by expanding spans, so that different drawing paths can be
+ * compared pixel for pixel. When useSpans is false, spans fall back to the default drawPixel implementation.
+ */
+class RecordingPlotter final : public TextPlotPipeline {
+private:
+    std::vector<uint32_t> pixels;
+    Coord where = {0,0};
+    Coord dims = {320, 200};
+    bool useSpans;
+    bool useBitmaps;
+    int spanCalls = 0;
+    int pixelCalls = 0;
+    int bitmapCalls = 0;
+    int dimensionCalls = 0;
+public:
+    explicit RecordingPlotter(bool useSpans, bool useBitmaps = false) : useSpans(useSpans), useBitmaps(useBitmaps) {}
+
+    void drawPixel(uint16_t x, uint16_t y, uint32_t color) override {
+        pixelCalls++;
+        pixels.push_back(((uint32_t)y << 16) | x);
+    }
+
+    void drawHorizontalSpan(uint16_t x, uint16_t y, uint16_t length, uint32_t color) override {
+        if (!useSpans) {
+            TextPlotPipeline::drawHorizontalSpan(x, y, length, color);
+            return;
+        }
+        spanCalls++;
+        for (uint16_t i = 0; i < length; i++) pixels.push_back(((uint32_t)y << 16) | (x + i));
+    }
+
+    bool drawMonoBitmap(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint8_t* bits, uint32_t fg) override {
+        if (!useBitmaps) return false;
+        bitmapCalls++;
+        forEachGlyphSpan(bits, w, h, [&](uint8_t col, uint8_t row, uint8_t len) {
+            for (uint8_t i = 0; i < len; i++) pixels.push_back(((uint32_t)(y + row) << 16) | (x + col + i));
+        });
+        return true;
+    }
+
+    void setCursor(const Coord &p) override { where = p; }
+    Coord getCursor() override { return where; }
+    Coord getDimensions() override {
+        dimensionCalls++;
+        return dims;
+    }
+    void setDimensions(const Coord& d) { dims = d; }
+
+    std::vector<uint32_t> sortedPixels() const {
+        auto sorted = pixels;
+        std::sort(sorted.begin(), sorted.end());
+        return sorted;
+    }
+    int getSpanCalls() const { return spanCalls; }
+    int getPixelCalls() const { return pixelCalls; }
+    int getBitmapCalls() const { return bitmapCalls; }
+    int getDimensionCalls() const { return dimensionCalls; }
+};
+
 UnicodeFontHandler* handler = nullptr;
 
 void setUp() {
@@ -121,14 +184,770 @@ void testAdafruitFont() {
     TEST_ASSERT_FALSE(handler->findCharInFont(127, glyphWithBitmap));
 }
 
+void testSpansDrawSamePixelsAsPixels() {
+    RecordingPlotter pixelPlotter(false);
+    RecordingPlotter spanPlotter(true);
+    const char* text = "AgyЖЩ|~";
+
+    UnicodeFontHandler pixelHandler(&pixelPlotter, ENCMODE_UTF8);
+    pixelHandler.setFont(OpenSansCyrillicLatin18);
+    pixelHandler.setCursor(10, 30);
+    pixelHandler.print(text);
+
+    UnicodeFontHandler spanHandler(&spanPlotter, ENCMODE_UTF8);
+    spanHandler.setFont(OpenSansCyrillicLatin18);
+    spanHandler.setCursor(10, 30);
+    spanHandler.print(text);
+
+    auto expected = pixelPlotter.sortedPixels();
+    auto actual = spanPlotter.sortedPixels();
+    TEST_ASSERT_TRUE(!expected.empty());
+    TEST_ASSERT_EQUAL(expected.size(), actual.size());
+    TEST_ASSERT_TRUE(expected == actual);
+    TEST_ASSERT_EQUAL(0, spanPlotter.getPixelCalls());
+    TEST_ASSERT_TRUE(spanPlotter.getSpanCalls() < (int)actual.size());
+}
+
+void testMonoBitmapUsedForVisibleGlyphs() {
+    RecordingPlotter spanPlotter(true);
+    RecordingPlotter bitmapPlotter(true, true);
+
+    UnicodeFontHandler spanHandler(&spanPlotter, ENCMODE_UTF8);
+    spanHandler.setFont(RobotoMedium24);
+    spanHandler.setCursor(5, 40);
+    spanHandler.print("Wq8");
+
+    UnicodeFontHandler bitmapHandler(&bitmapPlotter, ENCMODE_UTF8);
+    bitmapHandler.setFont(RobotoMedium24);
+    bitmapHandler.setCursor(5, 40);
+    bitmapHandler.print("Wq8");
+
+    TEST_ASSERT_TRUE(spanPlotter.sortedPixels() == bitmapPlotter.sortedPixels());
+    TEST_ASSERT_EQUAL(3, bitmapPlotter.getBitmapCalls());
+    TEST_ASSERT_EQUAL(0, bitmapPlotter.getSpanCalls());
+
+    // a glyph that is partly off the top of the display must not be handed to the pipeline as a bitmap
+    RecordingPlotter clippedPlotter(true, true);
+    UnicodeFontHandler clippedHandler(&clippedPlotter, ENCMODE_UTF8);
+    clippedHandler.setFont(RobotoMedium24);
+    clippedHandler.setCursor(5, 10);
+    clippedHandler.print("W");
+    TEST_ASSERT_EQUAL(0, clippedPlotter.getBitmapCalls());
+    TEST_ASSERT_TRUE(clippedPlotter.getSpanCalls() > 0);
+}
+
+void testGlyphsClippedAtNegativeCoordinates() {
+    // draw well inside a large display as the reference, then move it so that it is clipped top and left.
+    RecordingPlotter reference(true);
+    reference.setDimensions(Coord(1000, 1000));
+    UnicodeFontHandler referenceHandler(&reference, ENCMODE_UTF8);
+    referenceHandler.setFont(OpenSansCyrillicLatin18);
+    referenceHandler.setCursor(93, 112);
+    referenceHandler.print("Wj");
+
+    std::vector<uint32_t> expected;
+    for (auto px : reference.sortedPixels()) {
+        int x = int(px & 0xffff) - 100;
+        int y = int(px >> 16) - 100;
+        if (x >= 0 && y >= 0 && x < 320 && y < 200) expected.push_back(((uint32_t)y << 16) | x);
+    }
+    std::sort(expected.begin(), expected.end());
+
+    RecordingPlotter clipped(true);
+    UnicodeFontHandler clippedHandler(&clipped, ENCMODE_UTF8);
+    clippedHandler.setFont(OpenSansCyrillicLatin18);
+    clippedHandler.setCursor(-7, 12);
+    clippedHandler.print("Wj");
+
+    TEST_ASSERT_TRUE(!expected.empty());
+    TEST_ASSERT_TRUE(expected == clipped.sortedPixels());
+}
+
+void testPrintingStopsAtRightEdge() {
+    RecordingPlotter plotter(true);
+    plotter.setDimensions(Coord(30, 200));
+    UnicodeFontHandler narrowHandler(&plotter, ENCMODE_UTF8);
+    narrowHandler.setFont(OpenSansCyrillicLatin18);
+    narrowHandler.setCursor(0, 20);
+    narrowHandler.print("AAAAAAAAAAAAAAAAAAAA");
+
+    // A is 16 wide, so the third character starts past the edge, after which nothing more is drawn.
+    TEST_ASSERT_EQUAL(3, plotter.getDimensionCalls());
+    TEST_ASSERT_EQUAL(32, plotter.getCursor().x);
+    for (auto px : plotter.sortedPixels()) {
+        TEST_ASSERT_TRUE((px & 0xffff) < 30);
+    }
+
+    // the next line starts afresh, even a byte at a time
+    narrowHandler.setCursor(0, 50);
+    narrowHandler.write('A');
+    TEST_ASSERT_EQUAL(16, plotter.getCursor().x);
+}
+
+/**
+ * Stands in for an Arduino Stream, giving out a few bytes of its text each time it is read, as if it were arriving
+ * over a serial port.
+ */
+class TrickleStream {
+private:
+    const char* text;
+    size_t remaining;
+    size_t perCall;
+public:
+    TrickleStream(const char* text, size_t perCall) : text(text), remaining(strlen(text)), perCall(perCall) {}
+
+    int available() { return (int)(remaining < perCall ? remaining : perCall); }
+
+    size_t readBytes(char* buffer, size_t len) {
+        if (len > remaining) len = remaining;
+        memcpy(buffer, text, len);
+        text += len;
+        remaining -= len;
+        return len;
+    }
+};
+
+void testPrintFromSourceMatchesPrint() {
+    const char* text = "ЖЩ AgyЖЩ|~ Привіт Світ";
+    RecordingPlotter printPlotter(true);
+    UnicodeFontHandler printHandler(&printPlotter, ENCMODE_UTF8);
+    printHandler.setFont(OpenSansCyrillicLatin18);
+    printHandler.setCursor(5, 30);
+    printHandler.print(text);
+
+    // each size splits the multi byte sequences between reads in a different place.
+    for (size_t perCall = 1; perCall < 8; perCall++) {
+        RecordingPlotter streamPlotter(true);
+        UnicodeFontHandler streamHandler(&streamPlotter, ENCMODE_UTF8);
+        streamHandler.setFont(OpenSansCyrillicLatin18);
+        streamHandler.setCursor(5, 30);
+        TrickleStream stream(text, perCall);
+        size_t total = 0;
+        while (stream.available()) total += streamHandler.printFromSource(stream, 3);
+        TEST_ASSERT_EQUAL(strlen(text), total);
+        TEST_ASSERT_TRUE(printPlotter.sortedPixels() == streamPlotter.sortedPixels());
+    }
+}
+
+void testBrokenSequenceSameInBothUtf8Modes() {
+    // a lead byte that breaks a sequence starts a new one, the handler resetting on the error must not lose it
+    const char* brokenTexts[] = { "\xD0\xD0\x9F", "A\xE2\x82\xD0\x9F" "B", "\xF0\x9F\xE2\x82\xAC!" };
+    RecordingPlotter sizing(true);
+    UnicodeFontHandler tableSizing(&sizing, ENCMODE_UTF8_TABLE);
+    tableSizing.setFont(OpenSansCyrillicLatin18);
+    TEST_ASSERT_EQUAL(tableSizing.textExtents("П", nullptr).x, tableSizing.textExtents(brokenTexts[0], nullptr).x);
+
+    for (auto text : brokenTexts) {
+        RecordingPlotter conditional(true);
+        UnicodeFontHandler conditionalHandler(&conditional, ENCMODE_UTF8);
+        conditionalHandler.setFont(OpenSansCyrillicLatin18);
+        RecordingPlotter table(true);
+        UnicodeFontHandler tableHandler(&table, ENCMODE_UTF8_TABLE);
+        tableHandler.setFont(OpenSansCyrillicLatin18);
+
+        int conditionalWidth = conditionalHandler.textExtents(text, nullptr).x;
+        TEST_ASSERT_TRUE(conditionalWidth > 0);
+        TEST_ASSERT_EQUAL(conditionalWidth, tableHandler.textExtents(text, nullptr).x);
+
+        conditionalHandler.setCursor(5, 30);
+        conditionalHandler.print(text);
+        tableHandler.setCursor(5, 30);
+        tableHandler.print(text);
+        TEST_ASSERT_TRUE(!conditional.sortedPixels().empty());
+        TEST_ASSERT_TRUE(conditional.sortedPixels() == table.sortedPixels());
+    }
+}
+
+void testUnsupportedBitmapFormatAdvancesWithoutDrawing() {
+    RecordingPlotter normalPlotter(true);
+    UnicodeFontHandler normalHandler(&normalPlotter, ENCMODE_UTF8);
+    normalHandler.setFont(OpenSansCyrillicLatin18);
+    normalHandler.setCursor(5, 30);
+    normalHandler.print("AЖ");
+
+    UnicodeFont futureFont = *OpenSansCyrillicLatin18;
+    futureFont.bitmapFormat = (BitmapFormat)0x7F;
+    RecordingPlotter futurePlotter(true);
+    UnicodeFontHandler futureHandler(&futurePlotter, ENCMODE_UTF8);
+    futureHandler.setFont(&futureFont);
+    futureHandler.setCursor(5, 30);
+    futureHandler.print("AЖ");
+
+    TEST_ASSERT_TRUE(!normalPlotter.sortedPixels().empty());
+    TEST_ASSERT_TRUE(futurePlotter.sortedPixels().empty());
+    TEST_ASSERT_EQUAL(normalPlotter.getCursor().x, futurePlotter.getCursor().x);
+}
+
+/**
+ * A pipeline that does not derive from TextPlotPipeline at all, it only works with a handler bound to its type.
+ */
+struct StaticSpanPipeline {
+    std::vector<uint32_t> pixels;
+    Coord where = {0,0};
+
+    void drawHorizontalSpan(uint16_t x, uint16_t y, uint16_t length, uint32_t color) {
+        for (uint16_t i = 0; i < length; i++) pixels.push_back(((uint32_t)y << 16) | (x + i));
+    }
+    bool drawMonoBitmap(uint16_t, uint16_t, uint16_t, uint16_t, const uint8_t*, uint32_t) { return false; }
+    bool beginPixelWindow(uint16_t, uint16_t, uint16_t, uint16_t) { return false; }
+    void pushPixels(uint32_t, uint32_t) { }
+    void endPixelWindow() { }
+    void setCursor(const Coord &p) { where = p; }
+    Coord getCursor() { return where; }
+    Coord getDimensions() { return Coord(320, 200); }
+};
+
+void testStaticPipelineHandlerMatchesVirtual() {
+    const char* text = "AgyЖЩ|~ Привіт";
+    RecordingPlotter virtualPlotter(true);
+    UnicodeFontHandler virtualHandler(&virtualPlotter, ENCMODE_UTF8);
+    virtualHandler.setFont(OpenSansCyrillicLatin18);
+    virtualHandler.setCursor(-3, 30);
+    virtualHandler.print(text);
+
+    RecordingPlotter boundPlotter(true);
+    BasicUnicodeFontHandler<RecordingPlotter> boundHandler(&boundPlotter, ENCMODE_UTF8);
+    boundHandler.setFont(OpenSansCyrillicLatin18);
+    boundHandler.setCursor(-3, 30);
+    boundHandler.print(text);
+    TEST_ASSERT_TRUE(!virtualPlotter.sortedPixels().empty());
+    TEST_ASSERT_TRUE(virtualPlotter.sortedPixels() == boundPlotter.sortedPixels());
+    TEST_ASSERT_EQUAL(virtualPlotter.getCursor().x, boundPlotter.getCursor().x);
+
+    StaticSpanPipeline staticPipeline;
+    BasicUnicodeFontHandler<StaticSpanPipeline> staticHandler(&staticPipeline, ENCMODE_UTF8);
+    staticHandler.setFont(OpenSansCyrillicLatin18);
+    staticHandler.setCursor(-3, 30);
+    staticHandler.print(text);
+    std::sort(staticPipeline.pixels.begin(), staticPipeline.pixels.end());
+    TEST_ASSERT_TRUE(virtualPlotter.sortedPixels() == staticPipeline.pixels);
+
+    int baseline = 0, staticBaseline = 0;
+    TEST_ASSERT_EQUAL(virtualHandler.textExtents(text, &baseline).x, staticHandler.textExtents(text, &staticBaseline).x);
+    TEST_ASSERT_EQUAL(baseline, staticBaseline);
+}
+
+/**
+ * The original bit at a time decoder, kept here as the reference that forEachGlyphSpan must match.
+ */
+std::vector<uint32_t> referenceGlyphSpans(const uint8_t* bitmap, uint8_t w, uint8_t firstRow, uint8_t endRow) {
+    std::vector<uint32_t> spans;
+    uint32_t bitPosition = (uint32_t)firstRow * w;
+    for (uint8_t yy = firstRow; yy < endRow; yy++) {
+        int spanStart = -1;
+        for (uint8_t xx = 0; xx <= w; xx++, bitPosition++) {
+            bool set = xx < w && (bitmap[bitPosition >> 3] & (0x80 >> (bitPosition & 7)));
+            if (set && spanStart < 0) {
+                spanStart = xx;
+            } else if (!set && spanStart >= 0) {
+                spans.push_back(((uint32_t)yy << 16) | (spanStart << 8) | (xx - spanStart));
+                spanStart = -1;
+            }
+        }
+        bitPosition--;
+    }
+    return spans;
+}
+
+void checkSpansMatchReference(const UnicodeFont* font) {
+    handler->setFont(font);
+    GlyphWithBitmap gb;
+    int glyphsChecked = 0;
+    uint8_t copy[4200];
+    for (uint32_t code = 0; code < 0x500; code++) {
+        if (!handler->findCharInFont(code, gb)) continue;
+        glyphsChecked++;
+        auto glyph = gb.getGlyph();
+        size_t bytes = (((size_t)glyph->width * glyph->height) + 7) / 8;
+        TEST_ASSERT_TRUE(bytes + 4 <= sizeof copy);
+
+        // copy at each alignment, so that both the word and byte reads are used.
+        for (int align = 0; align < 4; align++) {
+            uint8_t* bitmap = copy + ((4 - ((uintptr_t)copy & 3)) & 3) + align;
+            memcpy(bitmap, gb.getBitmapData(), bytes);
+            int rowRanges[3][2] = { {0, glyph->height}, {glyph->height / 3, glyph->height}, {1, glyph->height / 2} };
+            for (auto& range : rowRanges) {
+                if (range[0] >= range[1]) continue;
+                std::vector<uint32_t> actual;
+                forEachGlyphSpan(bitmap, glyph->width, range[0], range[1], [&](uint8_t col, uint8_t row, uint8_t len) {
+                    actual.push_back(((uint32_t)row << 16) | (col << 8) | len);
+                });
+                if (actual != referenceGlyphSpans(bitmap, glyph->width, range[0], range[1])) {
+                    printf("Spans differ for code %d align %d rows %d-%d\n", code, align, range[0], range[1]);
+                    TEST_FAIL();
+                }
+            }
+        }
+    }
+    TEST_ASSERT_TRUE(glyphsChecked > 90);
+}
+
+void testSpansMatchReferenceDecoder() {
+    checkSpansMatchReference(OpenSansCyrillicLatin18);
+    checkSpansMatchReference(RobotoMedium24);
+}
+
+void printOpenSansAt(UnicodeFontHandler& fontHandler, int x, int y, const char* text) {
+    fontHandler.setFont(OpenSansCyrillicLatin18);
+    fontHandler.setCursor(x, y);
+    fontHandler.print(text);
+}
+
+void testSpanCacheDrawsSamePixels() {
+    const char* text = "12:45 °C Жy";
+    RecordingPlotter reference(true);
+    UnicodeFontHandler referenceHandler(&reference, ENCMODE_UTF8);
+    printOpenSansAt(referenceHandler, 4, 30, text);
+
+    RecordingPlotter cached(true, true);
+    UnicodeFontHandler cachedHandler(&cached, ENCMODE_UTF8);
+    TEST_ASSERT_NULL(cachedHandler.getSpanCache());
+    GlyphSpanCache cache(2048);
+    cachedHandler.setSpanCache(&cache);
+    TEST_ASSERT_EQUAL_PTR(&cache, cachedHandler.getSpanCache());
+    TEST_ASSERT_TRUE(cache.isEnabled());
+
+    // the first print fills the cache, the second is drawn entirely from it, neither uses the bitmap path
+    printOpenSansAt(cachedHandler, 4, 30, text);
+    TEST_ASSERT_TRUE(reference.sortedPixels() == cached.sortedPixels());
+    uint32_t misses = cache.getMisses();
+    TEST_ASSERT_EQUAL(1, cache.getHits()); // both of the spaces are drawn from one entry
+    TEST_ASSERT_EQUAL(cache.getGlyphCount(), misses);
+    TEST_ASSERT_EQUAL(0, cached.getBitmapCalls());
+
+    RecordingPlotter again(true);
+    cachedHandler.setTextPlotPipeline(&again);
+    printOpenSansAt(cachedHandler, 4, 30, text);
+    TEST_ASSERT_TRUE(reference.sortedPixels() == again.sortedPixels());
+    TEST_ASSERT_EQUAL(misses, cache.getMisses());
+    TEST_ASSERT_EQUAL(misses + 2, cache.getHits());
+
+    // cached spans are for the whole glyph, so they must still be clipped at the edges of the display
+    RecordingPlotter clippedReference(true);
+    clippedReference.setDimensions(Coord(60, 200));
+    UnicodeFontHandler clippedReferenceHandler(&clippedReference, ENCMODE_UTF8);
+    printOpenSansAt(clippedReferenceHandler, -5, 8, text);
+    RecordingPlotter clipped(true);
+    clipped.setDimensions(Coord(60, 200));
+    cachedHandler.setTextPlotPipeline(&clipped);
+    printOpenSansAt(cachedHandler, -5, 8, text);
+    TEST_ASSERT_TRUE(!clipped.sortedPixels().empty());
+    TEST_ASSERT_TRUE(clippedReference.sortedPixels() == clipped.sortedPixels());
+}
+
+void testSpanCacheStaysWithinBudget() {
+    const char* text = "ЖЩWAgy0123456789";
+    RecordingPlotter reference(true);
+    UnicodeFontHandler referenceHandler(&reference, ENCMODE_UTF8);
+    printOpenSansAt(referenceHandler, 0, 30, text);
+
+    // far too small to hold the whole text, so glyphs are evicted as it is drawn, over and over
+    RecordingPlotter cached(true);
+    UnicodeFontHandler cachedHandler(&cached, ENCMODE_UTF8);
+    GlyphSpanCache cache(300);
+    cachedHandler.setSpanCache(&cache);
+    for (int i = 0; i < 5; i++) {
+        RecordingPlotter plotter(true);
+        cachedHandler.setTextPlotPipeline(&plotter);
+        printOpenSansAt(cachedHandler, 0, 30, text);
+        TEST_ASSERT_TRUE(reference.sortedPixels() == plotter.sortedPixels());
+        TEST_ASSERT_TRUE(cache.getBytesUsed() <= cache.getByteBudget());
+        TEST_ASSERT_TRUE(cache.getGlyphCount() > 0);
+    }
+
+    // a glyph that cannot fit in the budget at all is still drawn, just never cached
+    RecordingPlotter tiny(true);
+    cachedHandler.setTextPlotPipeline(&tiny);
+    cache.setByteBudget(16);
+    printOpenSansAt(cachedHandler, 0, 30, text);
+    TEST_ASSERT_TRUE(reference.sortedPixels() == tiny.sortedPixels());
+    TEST_ASSERT_EQUAL(0, cache.getGlyphCount());
+
+    // however large the budget, no more than the maximum number of glyphs are kept, so lookups stay short
+    const char* alphabet[] = { "ABCDEFGHIJKLM", "NOPQRSTUVWXYZ", "abcdefghijklm", "nopqrstuvwxyz" };
+    RecordingPlotter alphabetReference(true);
+    referenceHandler.setTextPlotPipeline(&alphabetReference);
+    RecordingPlotter large(true);
+    cachedHandler.setTextPlotPipeline(&large);
+    cache.setByteBudget(8192);
+    for (int line = 0; line < 4; line++) {
+        printOpenSansAt(referenceHandler, 0, 30 + (line * 30), alphabet[line]);
+        printOpenSansAt(cachedHandler, 0, 30 + (line * 30), alphabet[line]);
+    }
+    TEST_ASSERT_TRUE(alphabetReference.sortedPixels() == large.sortedPixels());
+    TEST_ASSERT_EQUAL(TC_GLYPH_SPAN_CACHE_MAX_GLYPHS, cache.getGlyphCount());
+
+    cache.setByteBudget(0);
+    TEST_ASSERT_FALSE(cache.isEnabled());
+}
+
+/**
+ * Keeps the color of every pixel of a small display, optionally supporting pixel windows, so that opaque drawing can be
+ * checked for both the background and foreground and that nothing is drawn outside the display.
+ */
+class ColorGridPlotter : public TextPlotPipeline {
+private:
+    static const int gridWidth = 160;
+    static const int gridHeight = 40;
+    std::vector<uint32_t> grid;
+    Coord where = {0,0};
+    bool useWindows;
+    int windowLeft = 0, windowTop = 0, windowWidth = 0, windowHeight = 0, windowFilled = 0;
+    int windowCalls = 0;
+    int spanCalls = 0;
+    bool outOfBounds = false;
+
+    void set(int x, int y, uint32_t color) {
+        if (x < 0 || y < 0 || x >= gridWidth || y >= gridHeight) {
+            outOfBounds = true;
+            return;
+        }
+        grid[(y * gridWidth) + x] = color;
+    }
+public:
+    explicit ColorGridPlotter(bool useWindows, uint32_t initial) : grid(gridWidth * gridHeight, initial), useWindows(useWindows) {}
+
+    void drawPixel(uint16_t x, uint16_t y, uint32_t color) override { set(x, y, color); }
+    void drawHorizontalSpan(uint16_t x, uint16_t y, uint16_t length, uint32_t color) override {
+        spanCalls++;
+        for (uint16_t i = 0; i < length; i++) set(x + i, y, color);
+    }
+    bool beginPixelWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) override {
+        if (!useWindows) return false;
+        if (x + w > gridWidth || y + h > gridHeight || w == 0 || h == 0) outOfBounds = true;
+        windowCalls++;
+        windowLeft = x;
+        windowTop = y;
+        windowWidth = w;
+        windowHeight = h;
+        windowFilled = 0;
+        return true;
+    }
+    void pushPixels(uint32_t color, uint32_t count) override {
+        for (uint32_t i = 0; i < count; i++, windowFilled++) {
+            if (windowFilled >= windowWidth * windowHeight) outOfBounds = true;
+            set(windowLeft + (windowFilled % windowWidth), windowTop + (windowFilled / windowWidth), color);
+        }
+    }
+    void endPixelWindow() override {
+        if (windowFilled != windowWidth * windowHeight) outOfBounds = true;
+    }
+    void setCursor(const Coord &p) override { where = p; }
+    Coord getCursor() override { return where; }
+    Coord getDimensions() override { return Coord(gridWidth, gridHeight); }
+
+    uint32_t at(int x, int y) const { return grid[(y * gridWidth) + x]; }
+    const std::vector<uint32_t>& getGrid() const { return grid; }
+    int getWindowCalls() const { return windowCalls; }
+    int getSpanCalls() const { return spanCalls; }
+    bool wasOutOfBounds() const { return outOfBounds; }
+};
+
+const uint32_t untouchedColor = 7;
+const uint32_t textColor = 1;
+const uint32_t paperColor = 2;
+
+void drawOpaqueAt(ColorGridPlotter& plotter, int x, int y, const char* text, size_t spanBudget = 0) {
+    UnicodeFontHandler opaqueHandler(&plotter, ENCMODE_UTF8);
+    GlyphSpanCache spanCache(spanBudget);
+    if (spanBudget != 0) opaqueHandler.setSpanCache(&spanCache);
+    opaqueHandler.setFont(OpenSansCyrillicLatin18);
+    opaqueHandler.setDrawColor(textColor);
+    opaqueHandler.setBackgroundColor(paperColor);
+    opaqueHandler.setOpaqueText(true);
+    opaqueHandler.setCursor(x, y);
+    opaqueHandler.print(text);
+    opaqueHandler.print(text); // the second time drawn from the span cache when there is one
+}
+
+void testOpaqueTextPaintsWholeCells() {
+    // glyphs that are entirely within their cells, so transparent and opaque drawing set the same foreground bits
+    const char* text = "1234";
+    handler->setFont(OpenSansCyrillicLatin18);
+    int baseline = handler->getBaseline();
+    int yAdvance = handler->getYAdvance();
+    GlyphWithBitmap gb;
+    for (const char* c = text; *c; c++) {
+        TEST_ASSERT_TRUE(handler->findCharInFont(*c, gb));
+        TEST_ASSERT_TRUE(gb.getGlyph()->xOffset >= 0 && gb.getGlyph()->xOffset + gb.getGlyph()->width <= gb.getGlyph()->xAdvance);
+        TEST_ASSERT_TRUE(gb.getGlyph()->yOffset >= baseline - yAdvance && gb.getGlyph()->yOffset + gb.getGlyph()->height <= baseline);
+    }
+
+    ColorGridPlotter transparent(false, untouchedColor);
+    UnicodeFontHandler transparentHandler(&transparent, ENCMODE_UTF8);
+    transparentHandler.setFont(OpenSansCyrillicLatin18);
+    transparentHandler.setDrawColor(textColor);
+    transparentHandler.setCursor(3, 25);
+    transparentHandler.print(text);
+    transparentHandler.print(text);
+    int textWidth = 2 * transparentHandler.textExtents(text, nullptr).x;
+
+    ColorGridPlotter spans(false, untouchedColor);
+    drawOpaqueAt(spans, 3, 25, text);
+    int insideCells = 0;
+    for (int y = 0; y < 40; y++) {
+        for (int x = 0; x < 160; x++) {
+            bool inCell = x >= 3 && x < 3 + textWidth && y >= 25 - yAdvance + baseline && y < 25 + baseline;
+            uint32_t expected = untouchedColor;
+            if (inCell) {
+                insideCells++;
+                expected = (transparent.at(x, y) == textColor) ? textColor : paperColor;
+            }
+            if (spans.at(x, y) != expected) {
+                printf("Opaque pixel differs at %d, %d\n", x, y);
+                TEST_FAIL();
+            }
+        }
+    }
+    TEST_ASSERT_TRUE(insideCells > 0);
+    TEST_ASSERT_EQUAL(0, spans.getWindowCalls());
+
+    // streaming through a window gives exactly the same result, with one window for each glyph and no spans
+    ColorGridPlotter windows(true, untouchedColor);
+    drawOpaqueAt(windows, 3, 25, text);
+    TEST_ASSERT_TRUE(spans.getGrid() == windows.getGrid());
+    TEST_ASSERT_EQUAL(8, windows.getWindowCalls());
+    TEST_ASSERT_EQUAL(0, windows.getSpanCalls());
+    TEST_ASSERT_FALSE(windows.wasOutOfBounds());
+
+    ColorGridPlotter cachedWindows(true, untouchedColor);
+    drawOpaqueAt(cachedWindows, 3, 25, text, 1024);
+    TEST_ASSERT_TRUE(spans.getGrid() == cachedWindows.getGrid());
+}
+
+void testOpaqueTextClippedAtDisplayEdges() {
+    // cells that are off the top, left and right of the display must still fill only the visible part
+    const char* text = "WjЖy12Щ|";
+    for (int y : {4, 20, 50}) {
+        ColorGridPlotter spans(false, untouchedColor);
+        drawOpaqueAt(spans, -9, y, text);
+        ColorGridPlotter windows(true, untouchedColor);
+        drawOpaqueAt(windows, -9, y, text);
+        ColorGridPlotter cachedWindows(true, untouchedColor);
+        drawOpaqueAt(cachedWindows, -9, y, text, 300);
+
+        TEST_ASSERT_FALSE(spans.wasOutOfBounds());
+        TEST_ASSERT_FALSE(windows.wasOutOfBounds());
+        TEST_ASSERT_FALSE(cachedWindows.wasOutOfBounds());
+        TEST_ASSERT_TRUE(spans.getGrid() == windows.getGrid());
+        TEST_ASSERT_TRUE(spans.getGrid() == cachedWindows.getGrid());
+        TEST_ASSERT_TRUE(std::count(spans.getGrid().begin(), spans.getGrid().end(), paperColor) > 0);
+    }
+}
+
+void drawTransparentAt(ColorGridPlotter& plotter, int x, int y, const char* text) {
+    UnicodeFontHandler transparentHandler(&plotter, ENCMODE_UTF8);
+    transparentHandler.setFont(OpenSansCyrillicLatin18);
+    transparentHandler.setDrawColor(textColor);
+    transparentHandler.setCursor(x, y);
+    transparentHandler.print(text);
+}
+
+void testOpaqueTextKeepsInkOutsideTheCell() {
+    // 'j' starts to the left of its cell, the opaque text must have exactly the same ink as the transparent text,
+    // both for the 'j' itself and for the character it reaches back into.
+    GlyphWithBitmap gb;
+    handler->setFont(OpenSansCyrillicLatin18);
+    TEST_ASSERT_TRUE(handler->findCharInFont('j', gb));
+    TEST_ASSERT_TRUE(gb.getGlyph()->xOffset < 0);
+
+    ColorGridPlotter single(false, untouchedColor);
+    drawTransparentAt(single, 10, 25, "j");
+    int inkLeftOfCell = 0;
+    for (int y = 0; y < 40; y++) {
+        if (single.at(9, y) == textColor) inkLeftOfCell++;
+    }
+    TEST_ASSERT_TRUE(inkLeftOfCell > 0);
+
+    for (const char* text : {"j", "ij", "jjj", "Ajy"}) {
+        ColorGridPlotter transparent(false, untouchedColor);
+        drawTransparentAt(transparent, 10, 25, text);
+        for (bool useWindows : {false, true}) {
+            for (size_t spanBudget : {(size_t)0, (size_t)256}) {
+                ColorGridPlotter opaque(useWindows, untouchedColor);
+                UnicodeFontHandler opaqueHandler(&opaque, ENCMODE_UTF8);
+                GlyphSpanCache spanCache(spanBudget);
+                if (spanBudget != 0) opaqueHandler.setSpanCache(&spanCache);
+                opaqueHandler.setFont(OpenSansCyrillicLatin18);
+                opaqueHandler.setDrawColor(textColor);
+                opaqueHandler.setBackgroundColor(paperColor);
+                opaqueHandler.setOpaqueText(true);
+                opaqueHandler.setCursor(10, 25);
+                opaqueHandler.print(text);
+                TEST_ASSERT_FALSE(opaque.wasOutOfBounds());
+                for (int y = 0; y < 40; y++) {
+                    for (int x = 0; x < 160; x++) {
+                        if ((transparent.at(x, y) == textColor) != (opaque.at(x, y) == textColor)) {
+                            printf("Opaque ink of %s differs at %d, %d\n", text, x, y);
+                            TEST_FAIL();
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void testGlyphLookupsAreIndependent() {
+    GlyphWithBitmap first;
+    GlyphWithBitmap second;
+    TEST_ASSERT_NULL(first.getGlyph());
+
+    // each lookup must fill in its own glyph rather than sharing storage.
+    TEST_ASSERT_TRUE(handler->findCharInFont(65, first));
+    TEST_ASSERT_TRUE(handler->findCharInFont(1041, second));
+    TEST_ASSERT_TRUE(first.getGlyph() != second.getGlyph());
+    TEST_ASSERT_EQUAL(646, first.getGlyph()->relativeBmpOffset);
+    TEST_ASSERT_EQUAL(16, first.getGlyph()->width);
+    TEST_ASSERT_EQUAL(561, second.getGlyph()->relativeBmpOffset);
+    TEST_ASSERT_EQUAL(12, second.getGlyph()->width);
+
+    UnicodeFontHandler otherHandler(&unitTestPlotter, ENCMODE_UTF8);
+    otherHandler.setFont(RobotoMedium24);
+    GlyphWithBitmap third;
+    TEST_ASSERT_TRUE(otherHandler.findCharInFont(65, third));
+    TEST_ASSERT_EQUAL(1190, third.getGlyph()->relativeBmpOffset);
+    TEST_ASSERT_EQUAL(646, first.getGlyph()->relativeBmpOffset);
+}
+
+void testGlyphCacheHitsAndEviction() {
+    UnicodeGlyphCache cache(4);
+    TEST_ASSERT_EQUAL(4, cache.getCapacity());
+#ifndef ARDUINO
+    // rounding the largest sizes up to whole sets goes past 65535 entries, too much memory for a board.
+    UnicodeGlyphCache largest(65535);
+    TEST_ASSERT_EQUAL(65536, largest.getCapacity());
+#endif
+    handler->setGlyphCache(&cache);
+
+    GlyphWithBitmap gb;
+    for (uint32_t ch : {65U, 66U, 67U, 68U}) {
+        TEST_ASSERT_TRUE(handler->findCharInFont(ch, gb));
+    }
+    TEST_ASSERT_EQUAL(0, cache.getHits());
+    TEST_ASSERT_EQUAL(4, cache.getMisses());
+
+    // a cached glyph must be identical to the one looked up in the font
+    TEST_ASSERT_TRUE(handler->findCharInFont(65, gb));
+    TEST_ASSERT_EQUAL(1, cache.getHits());
+    TEST_ASSERT_EQUAL(646, gb.getGlyph()->relativeBmpOffset);
+    TEST_ASSERT_EQUAL(16, gb.getGlyph()->width);
+    TEST_ASSERT_EQUAL(-18, gb.getGlyph()->yOffset);
+    GlyphWithBitmap uncached;
+    handler->setGlyphCache(nullptr);
+    TEST_ASSERT_TRUE(handler->findCharInFont(65, uncached));
+    TEST_ASSERT_TRUE(uncached.getBitmapData() == gb.getBitmapData());
+    handler->setGlyphCache(&cache);
+
+    // 66 is now the least recently used, so storing 69 replaces it, but 65 stays
+    TEST_ASSERT_TRUE(handler->findCharInFont(69, gb));
+    TEST_ASSERT_TRUE(handler->findCharInFont(65, gb));
+    TEST_ASSERT_EQUAL(2, cache.getHits());
+    TEST_ASSERT_TRUE(handler->findCharInFont(66, gb));
+    TEST_ASSERT_EQUAL(2, cache.getHits());
+    TEST_ASSERT_EQUAL(6, cache.getMisses());
+
+    // the same code in a different font is a different entry
+    handler->setFont(RobotoMedium24);
+    TEST_ASSERT_TRUE(handler->findCharInFont(65, gb));
+    TEST_ASSERT_EQUAL(1190, gb.getGlyph()->relativeBmpOffset);
+    TEST_ASSERT_EQUAL(7, cache.getMisses());
+
+    cache.resetStatistics();
+    cache.clear();
+    TEST_ASSERT_TRUE(handler->findCharInFont(65, gb));
+    TEST_ASSERT_EQUAL(0, cache.getHits());
+    TEST_ASSERT_EQUAL(1, cache.getMisses());
+    handler->setGlyphCache(nullptr);
+}
+
+const uint8_t testBlockBitmap[] = { 0xff, 0xff, 0xff, 0xff };
+const UnicodeFontGlyph testBlockGlyphs[] = {
+        { 0, 0, 2, 2, 3, 0, -2 }, { 1, 1, 2, 2, 4, 0, -2 }, { 2, 2, 2, 2, 5, 0, -2 }, { 3, 3, 2, 2, 6, 0, -2 }
+};
+// a block from a generator that predates the glyph count, which leaves the count and flags as 0.
+const UnicodeFontBlock legacyBlocks[] = { {0x200A, testBlockBitmap, testBlockGlyphs, 4, 0, 0, nullptr} };
+const UnicodeFont legacyFont[] = { {legacyBlocks, 1, 10, TCFONT_ONE_BIT_PER_PIXEL} };
+const UnicodeFontBlock denseBlocks[] = { {0x200A, testBlockBitmap, testBlockGlyphs, 4, 4, TCFONT_BLOCK_DENSE, nullptr} };
+const UnicodeFont denseFont[] = { {denseBlocks, 1, 10, TCFONT_ONE_BIT_PER_PIXEL} };
+
+void testDenseAndSparseBlockLookup() {
+    GlyphWithBitmap gb;
+
+    // every glyph in the sparse cyrillic block must be found by search
+    handler->setFont(OpenSansCyrillicLatin18);
+    for (const auto& glyph : OpenSansCyrillicLatin18Glyphs_8) {
+        TEST_ASSERT_TRUE(handler->findCharInFont(1024 + glyph.relativeChar, gb));
+        TEST_ASSERT_EQUAL(glyph.relativeBmpOffset, gb.getGlyph()->relativeBmpOffset);
+    }
+
+    // both a dense block and one from a font without a glyph count must give the same results
+    for (auto font : {legacyFont, denseFont}) {
+        handler->setFont(font);
+        for (uint32_t i = 0; i < 4; i++) {
+            TEST_ASSERT_TRUE(handler->findCharInFont(0x200A + i, gb));
+            TEST_ASSERT_EQUAL(i, gb.getGlyph()->relativeBmpOffset);
+            TEST_ASSERT_EQUAL(3 + i, gb.getGlyph()->xAdvance);
+        }
+        TEST_ASSERT_FALSE(handler->findCharInFont(0x2009, gb));
+        TEST_ASSERT_FALSE(handler->findCharInFont(0x200E, gb));
+        TEST_ASSERT_FALSE(handler->findCharInFont(0x1FFF, gb));
+    }
+}
+
 #define RUN_TEST_WITH_PRINT(x) printf("test start " #x "\n"); RUN_TEST(x);
 
+#if __cplusplus >= 201703L
+void testPrintCodePointsMatchesPrint() {
+    constexpr auto label = TC_UTF8_LITERAL("AgyЖЩ|~ Привіт");
+    RecordingPlotter printPlotter(true);
+    UnicodeFontHandler printHandler(&printPlotter, ENCMODE_UTF8);
+    printHandler.setFont(OpenSansCyrillicLatin18);
+    printHandler.setCursor(5, 30);
+    printHandler.print("AgyЖЩ|~ Привіт");
+
+    RecordingPlotter literalPlotter(true);
+    UnicodeFontHandler literalHandler(&literalPlotter, ENCMODE_UTF8);
+    literalHandler.setFont(OpenSansCyrillicLatin18);
+    literalHandler.setCursor(5, 30);
+    literalHandler.printCodePoints(label.data(), label.size());
+
+    TEST_ASSERT_TRUE(printPlotter.sortedPixels() == literalPlotter.sortedPixels());
+    int baseline = 0, literalBaseline = 0;
+    auto expected = printHandler.textExtents("AgyЖЩ|~ Привіт", &baseline);
+    auto actual = literalHandler.textExtents(label.data(), label.size(), &literalBaseline);
+    TEST_ASSERT_EQUAL(expected.x, actual.x);
+    TEST_ASSERT_EQUAL(expected.y, actual.y);
+    TEST_ASSERT_EQUAL(baseline, literalBaseline);
+}
+#endif
+
 void setup() {
     UNITY_BEGIN();
     RUN_TEST_WITH_PRINT(testGetGlyphOnEachRange);
     RUN_TEST_WITH_PRINT(testReadingEveryGlyphInRange);
     RUN_TEST_WITH_PRINT(testAdafruitFont);
     RUN_TEST_WITH_PRINT(testTextExtents);
+    RUN_TEST_WITH_PRINT(testSpansDrawSamePixelsAsPixels);
+    RUN_TEST_WITH_PRINT(testSpansMatchReferenceDecoder);
+    RUN_TEST_WITH_PRINT(testMonoBitmapUsedForVisibleGlyphs);
+    RUN_TEST_WITH_PRINT(testGlyphsClippedAtNegativeCoordinates);
+    RUN_TEST_WITH_PRINT(testPrintingStopsAtRightEdge);
+    RUN_TEST_WITH_PRINT(testPrintFromSourceMatchesPrint);
+    RUN_TEST_WITH_PRINT(testBrokenSequenceSameInBothUtf8Modes);
+#if __cplusplus >= 201703L
+    RUN_TEST_WITH_PRINT(testPrintCodePointsMatchesPrint);
+#endif
+    RUN_TEST_WITH_PRINT(testUnsupportedBitmapFormatAdvancesWithoutDrawing);
+    RUN_TEST_WITH_PRINT(testStaticPipelineHandlerMatchesVirtual);
+    RUN_TEST_WITH_PRINT(testGlyphLookupsAreIndependent);
+    RUN_TEST_WITH_PRINT(testGlyphCacheHitsAndEviction);
+    RUN_TEST_WITH_PRINT(testSpanCacheDrawsSamePixels);
+    RUN_TEST_WITH_PRINT(testSpanCacheStaysWithinBudget);
+    RUN_TEST_WITH_PRINT(testOpaqueTextPaintsWholeCells);
+    RUN_TEST_WITH_PRINT(testOpaqueTextClippedAtDisplayEdges);
+    RUN_TEST_WITH_PRINT(testOpaqueTextKeepsInkOutsideTheCell);
+    RUN_TEST_WITH_PRINT(testDenseAndSparseBlockLookup);
     UNITY_END();
 }
 
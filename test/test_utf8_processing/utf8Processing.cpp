@@ -3,7 +3,19 @@
 #include <Arduino.h>
 #include <unity.h>
 #include <deque>
+#include <vector>
+#include <string>
+#include <algorithm>
 #include <Utf8TextProcessor.h>
+#include <Utf8BulkDecoder.h>
+#include <Utf8Iterator.h>
+#include <Utf8CodePages.h>
+#include <Utf8Encoder.h>
+#include <Utf8StringUtils.h>
+#include <Utf8StreamSource.h>
+#include <Utf8PackedDecoder.h>
+#include <Utf8ParallelDecoder.h>
+#include <Utf8Literal.h>
 
 std::deque<uint32_t> unicodeChars;
 const size_t max_size = 10;
@@ -203,6 +215,624 @@ void testUtf8EncoderReallyLargeCodes() {
     TEST_ASSERT_FALSE(!unicodeChars.empty());
 }
 
+std::vector<uint32_t> allChars;
+
+void allCharsHandler(void* handler, uint32_t charCode) {
+    allChars.push_back(charCode);
+}
+
+std::vector<uint32_t> decodeCharAtATime(const char* text) {
+    allChars.clear();
+    tccore::Utf8TextProcessor textProcessor(allCharsHandler, nullptr, tccore::ENCMODE_UTF8);
+    for (const char* p = text; *p; p++) textProcessor.pushChar(*p);
+    return allChars;
+}
+
+void testLongMixedTextMatchesCharAtATime() {
+    // long enough to cover several machine words, with non ASCII at different alignments
+    const char* text = "Hello world, this is plain ASCII text Світ and more ASCII 0123456789abcdef ﬓ end! "
+                       "x\xc3\xa9yz \xe2\x82\xac\xe2\x82\xac ABCDEFGHIJKLMNOP\xd1\x96 \xc3 broken \x80";
+
+    for (size_t offset = 0; offset < 8; offset++) {
+        auto expected = decodeCharAtATime(text + offset);
+        allChars.clear();
+        tccore::Utf8TextProcessor textProcessor(allCharsHandler, nullptr, tccore::ENCMODE_UTF8);
+        textProcessor.pushChars(text + offset);
+        TEST_ASSERT_TRUE(expected == allChars);
+    }
+
+    auto decoded = decodeCharAtATime(text);
+    TEST_ASSERT_EQUAL_UINT32(0x0421, decoded[38]);
+    TEST_ASSERT_EQUAL_UINT32(TC_UNICODE_CHAR_ERROR, decoded.back());
+    TEST_ASSERT_EQUAL(0, tccore::utf8AsciiPrefixLength("\x80", 1));
+    TEST_ASSERT_EQUAL(19, tccore::utf8AsciiPrefixLength("0123456789abcdefghi\xd1\x96", 21));
+}
+
+void testStrayContinuationBytes() {
+    tccore::Utf8TextProcessor textProcessor(textHandler, nullptr, tccore::ENCMODE_UTF8);
+    textProcessor.pushChar('A');
+    textProcessor.pushChar((char)0x80);
+    textProcessor.pushChar((char)0xBF);
+    textProcessor.pushChar((char)0xF8);
+    textProcessor.pushChar('B');
+    TEST_ASSERT_EQUAL_UINT32('A', getFromBufferOrError());
+    TEST_ASSERT_EQUAL_UINT32(TC_UNICODE_CHAR_ERROR, getFromBufferOrError());
+    TEST_ASSERT_EQUAL_UINT32(TC_UNICODE_CHAR_ERROR, getFromBufferOrError());
+    TEST_ASSERT_EQUAL_UINT32(TC_UNICODE_CHAR_ERROR, getFromBufferOrError());
+    TEST_ASSERT_EQUAL_UINT32('B', getFromBufferOrError());
+    TEST_ASSERT_FALSE(!unicodeChars.empty());
+}
+
+std::vector<uint32_t> decodeByteAtATime(const uint8_t* data, size_t len,
+                                        tccore::UnicodeEncodingMode mode = tccore::ENCMODE_UTF8) {
+    allChars.clear();
+    tccore::Utf8TextProcessor textProcessor(allCharsHandler, nullptr, mode);
+    for (size_t i = 0; i < len; i++) textProcessor.pushChar((char)data[i]);
+    return allChars;
+}
+
+/**
+ * Fills data with runs of ascii long enough for the block kernels, mixed with valid and invalid sequences and random
+ * bytes, always ending on ascii so that no sequence is left part way through.
+ * @return the number of bytes written, always less than 600
+ */
+size_t makeMixedTestData(uint32_t& seed, uint8_t* data) {
+    const uint8_t fragments[][4] = {
+            {0xD0, 0x9F, 0, 0}, {0xE2, 0x82, 0xAC, 0}, {0xF0, 0x9F, 0x98, 0x80}, {0xC0, 0xAF, 0, 0},
+            {0xE0, 0x80, 0xAF, 0}, {0xED, 0xA0, 0x80, 0}, {0x80, 0, 0, 0}, {0xFE, 0, 0, 0}, {0xF8, 0x88, 0, 0},
+            {0xE2, 0x82, 0, 0}, {0xC3, 0xFF, 0, 0}, {0xF4, 0x90, 0x80, 0x80}
+    };
+    const size_t fragmentCount = sizeof(fragments) / sizeof(fragments[0]);
+    size_t len = 0;
+    while (len < 500) {
+        seed = seed * 1103515245U + 12345U;
+        int choice = (int)((seed >> 16) % 8);
+        if (choice < 3) {
+            int run = (int)((seed >> 8) % 40);
+            for (int i = 0; i < run; i++) data[len++] = (uint8_t)(' ' + ((i + seed) % 90));
+        } else if (choice < 7) {
+            const uint8_t* fragment = fragments[(seed >> 4) % fragmentCount];
+            for (int i = 0; i < 4 && (i == 0 || fragment[i] != 0); i++) data[len++] = fragment[i];
+        } else {
+            data[len++] = (uint8_t)(seed >> 3);
+        }
+    }
+    data[len++] = '.';
+    return len;
+}
+
+void testBulkDecodeMatchesProcessor() {
+    uint32_t seed = 12345;
+    uint8_t data[600];
+    uint32_t decoded[600];
+
+    for (int round = 0; round < 200; round++) {
+        size_t len = makeMixedTestData(seed, data);
+        auto expected = decodeByteAtATime(data, len);
+        auto result = tccore::decodeUtf8(data, len, decoded);
+        TEST_ASSERT_EQUAL(expected.size(), result.written);
+        TEST_ASSERT_EQUAL(std::count(expected.begin(), expected.end(), TC_UNICODE_CHAR_ERROR), result.errorCount);
+        TEST_ASSERT_TRUE(std::equal(expected.begin(), expected.end(), decoded));
+    }
+
+    // a nul that breaks a sequence is reported as the error and not passed on.
+    const uint8_t brokenByNul[] = { 0xC3, 0x00, 'a' };
+    auto result = tccore::decodeUtf8(brokenByNul, sizeof brokenByNul, decoded);
+    TEST_ASSERT_EQUAL(2, result.written);
+    TEST_ASSERT_TRUE(decodeByteAtATime(brokenByNul, sizeof brokenByNul) == std::vector<uint32_t>(decoded, decoded + 2));
+}
+
+void testBulkDecodeTwoByteRuns() {
+    // runs of two byte letters, with the edges of the range, overlong leads and runs broken part way
+    const char* texts[] = {
+            "Привіт Світ, меню: гучність 75%", "\xC2\x80\xDF\xBF\xC2\xBF\xDF\x80", "Жж\xC1\xBFЖ\xC0\x80ж",
+            "ЩЩ\xD0ЩЩ\xD0\xD0\x9F", "αβγ\xD0" "a", "ЖЖЖ\xE2\x82\xACЖЖ", "ЖЖЖЖ\xD0"
+    };
+    uint32_t decoded[64];
+    for (auto text : texts) {
+        auto data = (const uint8_t*)text;
+        size_t len = strlen(text);
+        auto expected = decodeByteAtATime(data, len);
+        if (len > 0 && (data[len - 1] & 0xE0) == 0xC0) expected.push_back(TC_UNICODE_CHAR_ERROR);
+        auto result = tccore::decodeUtf8(data, len, decoded);
+        TEST_ASSERT_EQUAL(expected.size(), result.written);
+        TEST_ASSERT_TRUE(std::equal(expected.begin(), expected.end(), decoded));
+    }
+}
+
+void testBulkDecodeReportsErrorPositions() {
+    const uint8_t data[] = { 'a', 0xC0, 0xAF, 0x80, 0xE2, 0x82, 'z', 0xF0, 0x9F };
+    uint32_t decoded[sizeof data];
+    size_t positions[4];
+    auto result = tccore::decodeUtf8(data, sizeof data, decoded, positions, 4);
+
+    TEST_ASSERT_EQUAL(6, result.written);
+    TEST_ASSERT_EQUAL(4, result.errorCount);
+    const uint32_t expectedChars[] = { 'a', TC_UNICODE_CHAR_ERROR, TC_UNICODE_CHAR_ERROR, TC_UNICODE_CHAR_ERROR, 'z',
+                                       TC_UNICODE_CHAR_ERROR };
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(expectedChars, decoded, 6);
+    // overlong found at its last byte, stray continuation, broken sequence found at 'z', truncated at its lead byte.
+    const size_t expectedPositions[] = { 2, 3, 6, 7 };
+    for (int i = 0; i < 4; i++) TEST_ASSERT_EQUAL(expectedPositions[i], positions[i]);
+
+    // fewer positions than errors still counts them all
+    result = tccore::decodeUtf8(data, sizeof data, decoded, positions, 1);
+    TEST_ASSERT_EQUAL(4, result.errorCount);
+    TEST_ASSERT_EQUAL(2, positions[0]);
+}
+
+void testBulkDecodeLongAsciiAndEmpty() {
+    char text[200];
+    for (int i = 0; i < 199; i++) text[i] = (char)('0' + (i % 70));
+    text[199] = 0;
+    uint32_t decoded[200];
+    auto result = tccore::decodeUtf8((const uint8_t*)text, 199, decoded);
+    TEST_ASSERT_EQUAL(199, result.written);
+    TEST_ASSERT_EQUAL(0, result.errorCount);
+    for (int i = 0; i < 199; i++) TEST_ASSERT_EQUAL_UINT32((uint8_t)text[i], decoded[i]);
+
+    result = tccore::decodeUtf8((const uint8_t*)text, 0, decoded);
+    TEST_ASSERT_EQUAL(0, result.written);
+    printf("Bulk decoder kernel: %s\n", tccore::utf8DecodeKernelName());
+}
+
+void checkTableDecoderPair(uint8_t first, uint8_t second) {
+    const uint8_t pair[] = { first, second, 0xE1, 0x80, first, 0x80, 0x80, 'x' };
+    auto expected = decodeByteAtATime(pair, sizeof pair);
+    TEST_ASSERT_TRUE(expected == decodeByteAtATime(pair, sizeof pair, tccore::ENCMODE_UTF8_TABLE));
+}
+
+void testTableDecoderMatchesConditionalDecoder() {
+    // pairs of bytes, followed by a lead byte, a continuation and ascii, cover each transition in the table. Both edges
+    // of every byte class are enough for that, on a host every pair of bytes is tried as well.
+    const uint8_t classEdges[] = {
+            0x00, 0x41, 0x7F, 0x80, 0x8F, 0x90, 0x9F, 0xA0, 0xBF, 0xC0, 0xC1, 0xC2, 0xDF, 0xE0, 0xE1, 0xEC, 0xED,
+            0xEE, 0xEF, 0xF0, 0xF1, 0xF3, 0xF4, 0xF5, 0xF7, 0xF8, 0xFF
+    };
+    for (auto first : classEdges) {
+        for (auto second : classEdges) checkTableDecoderPair(first, second);
+    }
+#ifndef ARDUINO
+    for (int first = 0; first < 256; first++) {
+        for (int second = 0; second < 256; second++) checkTableDecoderPair((uint8_t)first, (uint8_t)second);
+    }
+#endif
+
+    uint8_t data[600];
+
+    uint32_t seed = 98765;
+    for (int round = 0; round < 100; round++) {
+        size_t len = makeMixedTestData(seed, data);
+        auto expected = decodeByteAtATime(data, len);
+        TEST_ASSERT_TRUE(expected == decodeByteAtATime(data, len, tccore::ENCMODE_UTF8_TABLE));
+
+        // and the same again through the bulk path of pushChars, which only works on strings.
+        std::replace(data, data + len, (uint8_t)0, (uint8_t)'0');
+        data[len] = 0;
+        expected = decodeCharAtATime((const char*)data);
+        allChars.clear();
+        tccore::Utf8TextProcessor textProcessor(allCharsHandler, nullptr, tccore::ENCMODE_UTF8_TABLE);
+        textProcessor.pushChars((const char*)data);
+        TEST_ASSERT_TRUE(expected == allChars);
+    }
+}
+
+struct VectorSink {
+    std::vector<uint32_t>* chars;
+    void operator()(uint32_t ch) const { chars->push_back(ch); }
+};
+
+void testCompileTimeHandlerMatchesCallback() {
+    uint32_t seed = 4242;
+    uint8_t data[600];
+    const tccore::UnicodeEncodingMode modes[] = { tccore::ENCMODE_UTF8, tccore::ENCMODE_UTF8_TABLE, tccore::ENCMODE_EXT_ASCII };
+    for (auto mode : modes) {
+        for (int round = 0; round < 20; round++) {
+            size_t len = makeMixedTestData(seed, data);
+            auto expected = decodeByteAtATime(data, len, mode);
+
+            std::vector<uint32_t> actual;
+            tccore::BasicUtf8TextProcessor<VectorSink> processor(VectorSink{&actual}, mode);
+            for (size_t i = 0; i < len; i++) processor.pushChar((char)data[i]);
+            TEST_ASSERT_TRUE(expected == actual);
+        }
+    }
+}
+
+const char pgmGreeting[] PROGMEM = "Hi \xD0\x9F\xD1\x80\xD0\xB8\xE2\x82\xAC";
+
+void testIteratorMatchesProcessor() {
+    uint32_t seed = 777;
+    uint8_t data[600];
+    for (int round = 0; round < 100; round++) {
+        size_t len = makeMixedTestData(seed, data);
+        auto expected = decodeByteAtATime(data, len);
+        std::vector<uint32_t> actual;
+        for (uint32_t ch : tccore::Utf8View((const char*)data, len)) actual.push_back(ch);
+        TEST_ASSERT_TRUE(expected == actual);
+    }
+
+    // a sequence cut short by the end is one last error
+    std::vector<uint32_t> truncated;
+    for (uint32_t ch : tccore::Utf8View("ab\xE2\x82")) truncated.push_back(ch);
+    TEST_ASSERT_EQUAL(3, truncated.size());
+    TEST_ASSERT_EQUAL_UINT32(TC_UNICODE_CHAR_ERROR, truncated[2]);
+}
+
+void testIteratorCanGoBackAndReadProgmem() {
+    tccore::Utf8ProgmemView view(pgmGreeting);
+    const uint32_t expected[] = { 'H', 'i', ' ', 0x41F, 0x440, 0x438, 0x20AC };
+    size_t count = 0;
+    tccore::Utf8ProgmemIterator wordStart = view.end();
+    for (auto it = view.begin(); it != view.end(); ++it) {
+        TEST_ASSERT_EQUAL_UINT32(expected[count], *it);
+        if (count == 3) wordStart = it;
+        count++;
+    }
+    TEST_ASSERT_EQUAL(7, count);
+
+    // a saved iterator, or a saved byte position, carries on from the same character
+    TEST_ASSERT_EQUAL(3, wordStart.position());
+    TEST_ASSERT_EQUAL(5, wordStart.nextPosition());
+    TEST_ASSERT_EQUAL_UINT32(0x41F, *wordStart);
+    auto resumed = view.from(wordStart.nextPosition());
+    TEST_ASSERT_EQUAL_UINT32(0x440, *resumed);
+    ++resumed; ++resumed; ++resumed;
+    TEST_ASSERT_TRUE(resumed.atEnd());
+    TEST_ASSERT_TRUE(resumed == view.end());
+}
+
+void testExtendedAsciiCodePages() {
+    // "Привет" in each Cyrillic code page, and "Łódź" in ISO-8859-2
+    const char windows1251[] = "\xCF\xF0\xE8\xE2\xE5\xF2!";
+    const char koi8r[] = "\xF0\xD2\xC9\xD7\xC5\xD4!";
+    const char iso8859_2[] = "\xA3\xF3" "d" "\xBC";
+    const std::vector<uint32_t> privet = { 0x41F, 0x440, 0x438, 0x432, 0x435, 0x442, '!' };
+    const std::vector<uint32_t> lodz = { 0x141, 0xF3, 0x64, 0x17A };
+
+    allChars.clear();
+    tccore::Utf8TextProcessor textProcessor(allCharsHandler, nullptr, tccore::ENCMODE_EXT_ASCII);
+    textProcessor.setCodePage(tccore::codePageWindows1251);
+    textProcessor.pushChars(windows1251);
+    TEST_ASSERT_TRUE(privet == allChars);
+
+    allChars.clear();
+    textProcessor.setCodePage(tccore::codePageKoi8R);
+    for (const char* p = koi8r; *p; p++) textProcessor.pushChar(*p);
+    TEST_ASSERT_TRUE(privet == allChars);
+
+    allChars.clear();
+    textProcessor.setCodePage(tccore::codePageIso8859_2);
+    textProcessor.pushChars(iso8859_2);
+    TEST_ASSERT_TRUE(lodz == allChars);
+
+    // undefined entries are the replacement character, and without a table bytes pass through unchanged
+    allChars.clear();
+    textProcessor.setCodePage(tccore::codePageWindows1251);
+    textProcessor.pushChar((char)0x98);
+    textProcessor.setCodePage(nullptr);
+    textProcessor.pushChar((char)0xCF);
+    TEST_ASSERT_EQUAL(2, allChars.size());
+    TEST_ASSERT_EQUAL_UINT32(0xFFFD, allChars[0]);
+    TEST_ASSERT_EQUAL_UINT32(0xCF, allChars[1]);
+}
+
+void checkEncodeRoundTrip(uint32_t ch) {
+    char encoded[TC_UTF8_MAX_CHAR_BYTES];
+    uint32_t decoded[TC_UTF8_MAX_CHAR_BYTES];
+    size_t len = tccore::encodeUtf8(ch, encoded);
+    TEST_ASSERT_EQUAL(tccore::encodedUtf8Length(ch), len);
+    auto result = tccore::decodeUtf8((const uint8_t*)encoded, len, decoded);
+    TEST_ASSERT_EQUAL(1, result.written);
+    bool surrogate = ch >= 0xD800 && ch <= 0xDFFF;
+    TEST_ASSERT_EQUAL_UINT32(surrogate ? TC_UNICODE_REPLACEMENT_CHAR : ch, decoded[0]);
+}
+
+void testEncodeBoundaryCharactersRoundTrip() {
+    // each side of every encoded length, the surrogates, the lead byte of each length and the last code point
+    const uint32_t boundaries[] = {
+            0x00, 0x01, 0x7F, 0x80, 0xBF, 0xC0, 0xFF, 0x7FF, 0x800, 0xFFF, 0x1000, 0xD7FF, 0xD800, 0xDBFF, 0xDC00,
+            0xDFFF, 0xE000, 0xFFFD, 0xFFFF, 0x10000, 0x3FFFF, 0x40000, 0xFFFFF, 0x100000, 0x10FFFF
+    };
+    for (auto ch : boundaries) checkEncodeRoundTrip(ch);
+
+    char encoded[TC_UTF8_MAX_CHAR_BYTES];
+    TEST_ASSERT_EQUAL(3, tccore::encodeUtf8(0x110000, encoded));
+    TEST_ASSERT_EQUAL_MEMORY("\xEF\xBF\xBD", encoded, 3);
+
+#ifndef ARDUINO
+    // on a host there is time to try every character, too slow on a board.
+    for (uint32_t ch = 0; ch <= 0x10FFFF; ch++) checkEncodeRoundTrip(ch);
+#endif
+}
+
+void testTranscodeUtf16AndUtf32() {
+    // long enough runs of ascii to use the block conversion, around a pair, an unpaired surrogate and Cyrillic
+    std::vector<uint16_t> utf16;
+    std::vector<uint32_t> utf32;
+    std::string expected;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 21; j++) {
+            utf16.push_back('a' + j);
+            utf32.push_back('a' + j);
+            expected += (char)('a' + j);
+        }
+        utf16.push_back(0xD83D); utf16.push_back(0xDE00);
+        utf32.push_back(0x1F600);
+        expected += "\xF0\x9F\x98\x80";
+        utf16.push_back(0xDC00);
+        utf32.push_back(0xDC00);
+        expected += "\xEF\xBF\xBD";
+        utf16.push_back(0x416);
+        utf32.push_back(0x416);
+        expected += "\xD0\x96";
+    }
+
+    char out[300];
+    auto result = tccore::utf16ToUtf8(utf16.data(), utf16.size(), out, sizeof out);
+    TEST_ASSERT_EQUAL(utf16.size(), result.consumed);
+    TEST_ASSERT_TRUE(expected == std::string(out, result.written));
+
+    result = tccore::utf32ToUtf8(utf32.data(), utf32.size(), out, sizeof out);
+    TEST_ASSERT_EQUAL(utf32.size(), result.consumed);
+    TEST_ASSERT_TRUE(expected == std::string(out, result.written));
+
+    // when the output is too small, conversion stops on a character boundary and can carry on from there
+    for (size_t outSize = 0; outSize < expected.size(); outSize += 5) {
+        auto first = tccore::utf16ToUtf8(utf16.data(), utf16.size(), out, outSize);
+        TEST_ASSERT_TRUE(first.written <= outSize);
+        auto rest = tccore::utf16ToUtf8(utf16.data() + first.consumed, utf16.size() - first.consumed,
+                                        out + first.written, sizeof(out) - first.written);
+        TEST_ASSERT_TRUE(expected == std::string(out, first.written + rest.written));
+
+        first = tccore::utf32ToUtf8(utf32.data(), utf32.size(), out, outSize);
+        TEST_ASSERT_TRUE(first.written <= outSize);
+        rest = tccore::utf32ToUtf8(utf32.data() + first.consumed, utf32.size() - first.consumed,
+                                   out + first.written, sizeof(out) - first.written);
+        TEST_ASSERT_TRUE(expected == std::string(out, first.written + rest.written));
+    }
+}
+
+void testUtf16SurrogatePairSplitAcrossChunks() {
+    // the pair for U+1F600 is split between two chunks, the high surrogate must wait for the next chunk
+    const uint16_t first[] = { 'a', 0xD83D };
+    const uint16_t second[] = { 0xDE00, 'b' };
+    char out[16];
+
+    auto result = tccore::utf16ToUtf8(first, 2, out, sizeof out, false);
+    TEST_ASSERT_EQUAL(1, result.consumed);
+    TEST_ASSERT_EQUAL(1, result.written);
+
+    // the caller carries the unconsumed unit over to the front of the next chunk, which is the final one
+    const uint16_t carried[] = { first[1], second[0], second[1] };
+    auto rest = tccore::utf16ToUtf8(carried, 3, out + result.written, sizeof(out) - result.written, true);
+    TEST_ASSERT_EQUAL(3, rest.consumed);
+    TEST_ASSERT_EQUAL(5, rest.written);
+    TEST_ASSERT_EQUAL_MEMORY("a\xF0\x9F\x98\x80" "b", out, 6);
+
+    // a high surrogate on its own that is not in the final chunk is never consumed, and nothing is written for it
+    result = tccore::utf16ToUtf8(first + 1, 1, out, sizeof out, false);
+    TEST_ASSERT_EQUAL(0, result.consumed);
+    TEST_ASSERT_EQUAL(0, result.written);
+
+    // in the final chunk, which is the default, it is an unpaired surrogate and is written as U+FFFD
+    result = tccore::utf16ToUtf8(first, 2, out, sizeof out);
+    TEST_ASSERT_EQUAL(2, result.consumed);
+    TEST_ASSERT_EQUAL(4, result.written);
+    TEST_ASSERT_EQUAL_MEMORY("a\xEF\xBF\xBD", out, 4);
+}
+
+void testStringUtilitiesAgreeWithIterator() {
+    uint32_t seed = 31337;
+    uint8_t data[600];
+    for (int round = 0; round < 30; round++) {
+        size_t len = makeMixedTestData(seed, data);
+        // drop the final full stop now and then, so that some text ends part way through a sequence.
+        if (round & 1) len--;
+        auto text = (const char*)data;
+
+        std::vector<size_t> boundaries;
+        bool valid = true;
+        tccore::Utf8View view(text, len);
+        for (auto it = view.begin(); it != view.end(); ++it) {
+            boundaries.push_back(it.position());
+            if (*it == TC_UNICODE_CHAR_ERROR && valid) {
+                valid = false;
+                size_t errorAt = 0;
+                TEST_ASSERT_FALSE(tccore::utf8IsValid(text, len, &errorAt));
+                TEST_ASSERT_EQUAL(it.position(), errorAt);
+            }
+        }
+        if (valid) TEST_ASSERT_TRUE(tccore::utf8IsValid(text, len));
+
+        TEST_ASSERT_EQUAL(boundaries.size(), tccore::utf8CountCharacters(text, len));
+        for (size_t i = 0; i < boundaries.size(); i++) {
+            TEST_ASSERT_EQUAL(boundaries[i], tccore::utf8OffsetOfCharacter(text, len, i));
+        }
+        TEST_ASSERT_EQUAL(len, tccore::utf8OffsetOfCharacter(text, len, boundaries.size()));
+
+        boundaries.push_back(len);
+        for (size_t budget = 0; budget <= len; budget++) {
+            // the longest length made of whole characters that fits the budget
+            size_t expected = *(std::upper_bound(boundaries.begin(), boundaries.end(), budget) - 1);
+            TEST_ASSERT_EQUAL(expected, tccore::utf8TruncatedLength(text, len, budget));
+        }
+    }
+}
+
+void testCopyTruncatedAndValidate() {
+    char dest[7];
+    TEST_ASSERT_EQUAL(4, tccore::utf8CopyTruncated(dest, sizeof dest, "ab\xD0\x96\xE2\x82\xAC"));
+    TEST_ASSERT_EQUAL_STRING("ab\xD0\x96", dest);
+    TEST_ASSERT_EQUAL(3, tccore::utf8CopyTruncated(dest, sizeof dest, "abc"));
+    TEST_ASSERT_EQUAL_STRING("abc", dest);
+    TEST_ASSERT_EQUAL(0, tccore::utf8CopyTruncated(dest, 1, "abc"));
+    TEST_ASSERT_EQUAL_STRING("", dest);
+
+    TEST_ASSERT_TRUE(tccore::utf8IsValid("Привіт Світ", strlen("Привіт Світ")));
+    size_t errorAt = 0;
+    TEST_ASSERT_FALSE(tccore::utf8IsValid("ok\xC0\xAF", 4, &errorAt));
+    TEST_ASSERT_EQUAL(2, errorAt);
+    TEST_ASSERT_FALSE(tccore::utf8IsValid("ok\xE2\x82", 4, &errorAt));
+    TEST_ASSERT_EQUAL(2, errorAt);
+    TEST_ASSERT_EQUAL(9, tccore::utf8CountCharacters("Привіт ok", strlen("Привіт ok")));
+}
+
+void testPushCharsWithLengthAcrossChunks() {
+    const char* text = "Hello \xD0\x9F\xD1\x80\xD0\xB8\xE2\x82\xAC \xF0\x9F\x98\x80 world, \xC0\xAF end";
+    auto expected = decodeCharAtATime(text);
+    size_t len = strlen(text);
+    for (size_t chunk = 1; chunk < 9; chunk++) {
+        allChars.clear();
+        tccore::Utf8TextProcessor textProcessor(allCharsHandler, nullptr, tccore::ENCMODE_UTF8);
+        for (size_t pos = 0; pos < len; pos += chunk) {
+            textProcessor.pushChars(text + pos, (len - pos) < chunk ? (len - pos) : chunk);
+        }
+        TEST_ASSERT_TRUE(expected == allChars);
+    }
+
+#ifdef TC_UTF8_HAS_FD_SOURCE
+    // and drained from a pipe, which is read in chunks of TC_UTF8_STREAM_CHUNK_SIZE
+    std::string longText;
+    for (int i = 0; i < 20; i++) longText += text;
+    int fds[2];
+    TEST_ASSERT_EQUAL(0, pipe(fds));
+    TEST_ASSERT_EQUAL(longText.size(), (size_t)write(fds[1], longText.data(), longText.size()));
+    tccore::Utf8FileDescriptorSource source(fds[0]);
+    allChars.clear();
+    tccore::Utf8TextProcessor textProcessor(allCharsHandler, nullptr, tccore::ENCMODE_UTF8);
+    TEST_ASSERT_EQUAL(longText.size(), tccore::utf8DrainIntoDecoder(source, textProcessor));
+    TEST_ASSERT_TRUE(decodeCharAtATime(longText.c_str()) == allChars);
+    close(fds[0]);
+    close(fds[1]);
+#endif
+}
+
+/** A fixed size output for one packed stream, so that interleaving streams does not need the heap */
+struct PackedStreamOutput {
+    uint32_t chars[160];
+    size_t count;
+    void operator()(uint32_t ch) { if (count < 160) chars[count++] = ch; }
+};
+
+void testManyPackedStreamsInterleaved() {
+    // several streams share one handler, each keeping only its 4 byte state, and receive their data in uneven pieces.
+    const int streamCount = 6;
+    const size_t streamLength = 150;
+    static uint8_t inputs[streamCount][streamLength];
+    static PackedStreamOutput outputs[streamCount];
+    static uint32_t expected[streamLength + 1];
+    tccore::Utf8PackedState states[streamCount];
+    size_t lengths[streamCount];
+    size_t fed[streamCount];
+    TEST_ASSERT_EQUAL(4, sizeof(tccore::Utf8PackedState));
+
+    // odd streams stop part way through whatever the mixed data has at that point, some within a sequence.
+    uint32_t seed = 2024;
+    uint8_t data[600];
+    for (int i = 0; i < streamCount; i++) {
+        makeMixedTestData(seed, data);
+        lengths[i] = streamLength - ((i & 1) ? (size_t)i : 0);
+        memcpy(inputs[i], data, lengths[i]);
+        states[i] = TC_UTF8_PACKED_INITIAL_STATE;
+        outputs[i].count = 0;
+        fed[i] = 0;
+    }
+
+    bool anyLeft = true;
+    while (anyLeft) {
+        anyLeft = false;
+        for (int i = 0; i < streamCount; i++) {
+            seed = seed * 1103515245U + 12345U;
+            size_t piece = (seed >> 16) % 7;
+            size_t left = lengths[i] - fed[i];
+            if (piece > left) piece = left;
+            auto& out = outputs[i];
+            states[i] = tccore::utf8Resume(states[i], (const char*)inputs[i] + fed[i], piece,
+                                           [&out](uint32_t ch) { out(ch); });
+            fed[i] += piece;
+            if (fed[i] < lengths[i]) anyLeft = true;
+        }
+    }
+
+    for (int i = 0; i < streamCount; i++) {
+        auto& out = outputs[i];
+        states[i] = tccore::utf8Finish(states[i], [&out](uint32_t ch) { out(ch); });
+        TEST_ASSERT_EQUAL(TC_UTF8_PACKED_INITIAL_STATE, states[i]);
+
+        auto result = tccore::decodeUtf8(inputs[i], lengths[i], expected);
+        TEST_ASSERT_EQUAL(result.written, out.count);
+        TEST_ASSERT_EQUAL_UINT32_ARRAY(expected, out.chars, out.count);
+    }
+
+    // and the function pointer version
+    allChars.clear();
+    auto state = tccore::utf8Resume(TC_UTF8_PACKED_INITIAL_STATE, "a\xD0", 2, allCharsHandler, nullptr);
+    TEST_ASSERT_FALSE(tccore::utf8PackedBetweenSequences(state));
+    state = tccore::utf8Resume(state, "\x96", 1, allCharsHandler, nullptr);
+    TEST_ASSERT_TRUE(tccore::utf8PackedBetweenSequences(state));
+    TEST_ASSERT_EQUAL(2, allChars.size());
+    TEST_ASSERT_EQUAL_UINT32(0x416, allChars[1]);
+}
+
+#ifdef TC_UTF8_HAS_PARALLEL_DECODE
+void checkParallelMatchesSingleThread(const std::vector<uint8_t>& data, unsigned threads) {
+    std::vector<uint32_t> expected(data.size()), actual(data.size());
+    std::vector<size_t> expectedErrors(5000), actualErrors(5000);
+    auto single = tccore::decodeUtf8(data.data(), data.size(), expected.data(), expectedErrors.data(), expectedErrors.size());
+    auto parallel = tccore::decodeUtf8Parallel(data.data(), data.size(), actual.data(), actualErrors.data(),
+                                               actualErrors.size(), threads);
+    TEST_ASSERT_EQUAL(single.written, parallel.written);
+    TEST_ASSERT_EQUAL(single.errorCount, parallel.errorCount);
+    TEST_ASSERT_TRUE(std::equal(expected.begin(), expected.begin() + single.written, actual.begin()));
+    TEST_ASSERT_TRUE(expectedErrors == actualErrors);
+
+    // with room for only a few positions, just those are filled in, and without an array only the count is kept
+    std::vector<size_t> fewExpected(10, 0), fewActual(10, 0);
+    tccore::decodeUtf8(data.data(), data.size(), expected.data(), fewExpected.data(), 7);
+    parallel = tccore::decodeUtf8Parallel(data.data(), data.size(), actual.data(), fewActual.data(), 7, threads);
+    TEST_ASSERT_EQUAL(single.errorCount, parallel.errorCount);
+    TEST_ASSERT_TRUE(fewExpected == fewActual);
+    parallel = tccore::decodeUtf8Parallel(data.data(), data.size(), actual.data(), nullptr, 100, threads);
+    TEST_ASSERT_EQUAL(single.written, parallel.written);
+    TEST_ASSERT_EQUAL(single.errorCount, parallel.errorCount);
+}
+
+void testParallelDecodeMatchesSingleThread() {
+    uint32_t seed = 555;
+    uint8_t chunk[600];
+    std::vector<uint8_t> data;
+    while (data.size() < 16 * TC_UTF8_PARALLEL_MIN_CHUNK) {
+        size_t len = makeMixedTestData(seed, chunk);
+        data.insert(data.end(), chunk, chunk + len - (seed & 1));
+    }
+    const unsigned threadCounts[] = { 2, 3, 7, 16 };
+    for (auto threads : threadCounts) checkParallelMatchesSingleThread(data, threads);
+
+    // text made only of broken sequences, so that every split lands next to one
+    const char* patterns[] = { "\xE2\x82", "\xF0\x9F\x98", "\xC3\xF8", "\x80\x80\xFE" };
+    for (auto pattern : patterns) {
+        std::vector<uint8_t> broken;
+        while (broken.size() < 4 * TC_UTF8_PARALLEL_MIN_CHUNK) broken.insert(broken.end(), pattern, pattern + strlen(pattern));
+        checkParallelMatchesSingleThread(broken, 4);
+    }
+}
+#endif
+
+#if __cplusplus >= 201703L
+constexpr auto literalGreeting = TC_UTF8_LITERAL("Hi Привіт € \xF0\x9F\x98\x80");
+static_assert(literalGreeting.size() == 13, "literal decoded at compile time");
+static_assert(literalGreeting[3] == 0x41F && literalGreeting[10] == 0x20AC && literalGreeting[12] == 0x1F600,
+              "characters decoded at compile time");
+static_assert(TC_UTF8_LITERAL("").size() == 0, "empty literal");
+
+void testLiteralMatchesRuntimeDecode() {
+    auto expected = decodeCharAtATime("Hi Привіт € \xF0\x9F\x98\x80");
+    TEST_ASSERT_EQUAL(expected.size(), literalGreeting.size());
+    TEST_ASSERT_TRUE(std::equal(expected.begin(), expected.end(), literalGreeting.begin()));
+}
+#endif
+
 void setup() {
     UNITY_BEGIN();
     RUN_TEST(testUtf8EncoderAscii);
@@ -214,6 +844,30 @@ void setup() {
     RUN_TEST(testinvalidBytesNotProcessed);
     RUN_TEST(testUtf8EncoderUnicodeOverlongSlash);
     RUN_TEST(testUtf8EncoderReallyLargeCodes);
+    RUN_TEST(testLongMixedTextMatchesCharAtATime);
+    RUN_TEST(testStrayContinuationBytes);
+    RUN_TEST(testBulkDecodeMatchesProcessor);
+    RUN_TEST(testBulkDecodeTwoByteRuns);
+    RUN_TEST(testBulkDecodeReportsErrorPositions);
+    RUN_TEST(testBulkDecodeLongAsciiAndEmpty);
+    RUN_TEST(testTableDecoderMatchesConditionalDecoder);
+    RUN_TEST(testCompileTimeHandlerMatchesCallback);
+    RUN_TEST(testIteratorMatchesProcessor);
+    RUN_TEST(testIteratorCanGoBackAndReadProgmem);
+    RUN_TEST(testExtendedAsciiCodePages);
+    RUN_TEST(testEncodeBoundaryCharactersRoundTrip);
+    RUN_TEST(testTranscodeUtf16AndUtf32);
+    RUN_TEST(testUtf16SurrogatePairSplitAcrossChunks);
+    RUN_TEST(testStringUtilitiesAgreeWithIterator);
+    RUN_TEST(testCopyTruncatedAndValidate);
+    RUN_TEST(testPushCharsWithLengthAcrossChunks);
+    RUN_TEST(testManyPackedStreamsInterleaved);
+#ifdef TC_UTF8_HAS_PARALLEL_DECODE
+    RUN_TEST(testParallelDecodeMatchesSingleThread);
+#endif
+#if __cplusplus >= 201703L
+    RUN_TEST(testLiteralMatchesRuntimeDecode);
+#endif
     UNITY_END();
 }
 